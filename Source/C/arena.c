@@ -0,0 +1,114 @@
+/********************************************************************************
+ *
+ * Arenas
+ *
+ *  © Phil Ngo, Tyler Clites 2012
+ *
+ * An arena hands out memory from a few large blocks, in order, and gives all of
+ * it back at once. A run of the harmonizer makes thousands of small objects that
+ * all live until the run is over, so it takes them from one arena and frees them
+ * with a single call instead of one free() per note. Each thread (or each job)
+ * keeps an arena of its own, so they never wait on each other for memory.
+ *
+********************************************************************************/
+
+#include "musicxml.h"
+
+// pieces start this far after their chunk header
+#define ARENA_HEADER ((sizeof(ArenaChunk) + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN)
+
+/**
+*   Returns an empty arena, NULL if memory runs out
+**/
+Arena* arenaAlloc(void)
+{
+    Arena* arena = malloc(sizeof(Arena));
+    if (arena == NULL)
+        return NULL;
+    arena->chunks = NULL;
+    return arena;
+}
+
+/**
+*   Frees every chunk of the arena, and the arena
+**/
+int arenaFree(Arena* arena)
+{
+    if (arena == NULL)
+        return 0;
+    ArenaChunk* chunk = arena->chunks;
+    while (chunk != NULL)
+    {
+        ArenaChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    free(arena);
+    return 0;
+}
+
+/**
+*   Returns size bytes from the arena, or from malloc() if arena is NULL.
+*   NULL if memory runs out
+**/
+void* arenaMalloc(Arena* arena, size_t size)
+{
+    if (arena == NULL)
+        return malloc(size);
+
+    size = (size + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+
+    // start a new chunk when this one is full. a piece bigger than a chunk gets one to itself
+    ArenaChunk* chunk = arena->chunks;
+    if (chunk == NULL || chunk->size - chunk->used < size)
+    {
+        size_t chunk_size = (size > ARENA_CHUNK) ? size : ARENA_CHUNK;
+        chunk = malloc(ARENA_HEADER + chunk_size);
+        if (chunk == NULL)
+            return NULL;
+        chunk->size = chunk_size;
+        chunk->used = 0;
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
+    }
+
+    chunk->last = chunk->used;
+    chunk->used += size;
+    return (char*) chunk + ARENA_HEADER + chunk->last;
+}
+
+/**
+*   Resizes a piece of the arena to size bytes, keeping what it holds. The latest
+*   piece grows in place if its chunk has room, any other is copied to a new one.
+*   Without an arena this is realloc(). NULL if memory runs out, ptr is then untouched
+**/
+void* arenaRealloc(Arena* arena, void* ptr, size_t old_size, size_t size)
+{
+    if (arena == NULL)
+        return realloc(ptr, size);
+    if (ptr == NULL)
+        return arenaMalloc(arena, size);
+
+    ArenaChunk* chunk = arena->chunks;
+    size_t rounded = (size + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+    if ((char*) ptr == (char*) chunk + ARENA_HEADER + chunk->last && chunk->size - chunk->last >= rounded)
+    {
+        chunk->used = chunk->last + rounded;
+        return ptr;
+    }
+
+    void* moved = arenaMalloc(arena, size);
+    if (moved == NULL)
+        return NULL;
+    memcpy(moved, ptr, (old_size < size) ? old_size : size);
+    return moved;
+}
+
+/**
+*   Frees a piece from malloc(). A piece of an arena stays until the arena is freed
+**/
+void arenaRelease(Arena* arena, void* ptr)
+{
+    if (arena == NULL)
+        free(ptr);
+}
@@ -0,0 +1,229 @@
+/********************************************************************************
+ *
+ * Edits
+ *
+ *  © Phil Ngo, Tyler Clites 2012
+ *
+ * When a note of the melody is fixed after the fact, only the chords near it
+ * and the voices under them need to change. reharmonizeTimeline() finds the
+ * best chords again for the nodes of the rhythm around the edit, fitted to the
+ * chords either side of them, then writes the voices again from there until
+ * they meet the notes they had before, or to the end of the measure after the
+ * edit, where they are led back to their old line. What it touches depends on
+ * the size of the edit, not on the length of the score, and the measures it
+ * reports are the only ones writeMeasures() has to write again.
+ *
+********************************************************************************/
+
+#include "musicxml.h"
+
+/**
+*   A cursor on a timeline, already at the note sounding at division
+**/
+static TimelineCursor cursorAt(Timeline* timeline, int division)
+{
+    TimelineCursor cursor = timelineCursor(timeline);
+    int index = timelineIndexAt(timeline, division);
+    cursor.index = (index >= 0) ? index : timeline->length;
+    return cursor;
+}
+
+/**
+*   The note of the range nearest to target, the lower of two as near, or fallback if
+*   the range is empty
+**/
+static int nearestNote(Range range, int target, int fallback)
+{
+    if (isInRange(range, target))
+        return target;
+    int up = rangeAbove(range, target);
+    int down = rangeBelow(range, target);
+    if (up == 0 && down == 0)
+        return fallback;
+    if (up == 0)
+        return down;
+    if (down == 0)
+        return up;
+    return (up - target < target - down) ? up : down;
+}
+
+/**
+*   Chooses the chords of nodes first to last again (viterbi, as in determineHarmoniesTimeline),
+*   each allowed after the one before, from the chord before first, or the tonic at the start,
+*   to the chord after last, or the tonic at the end. Keeps the old ones if none fit.
+*   Returns 0, or 1 on error
+**/
+static int reharmonizeNodes(Timeline* part, Timeline* rhythm, ChordTimeline* harmony, int key, int beats, int first, int last)
+{
+    int count = last - first + 1;
+    int before = (first > 0) ? harmony->function[first - 1] - 1 : -1;
+    int after = (last < harmony->length - 1) ? harmony->function[last + 1] - 1 : -1;
+
+    int (*bins)[7] = arenaMalloc(part->arena, sizeof(int[7]) * count);
+    int (*score)[7] = arenaMalloc(part->arena, sizeof(int[7]) * count);
+    int (*from)[7] = arenaMalloc(part->arena, sizeof(int[7]) * count);
+    if (bins == NULL || score == NULL || from == NULL ||
+            harmonyWeights(part, rhythm, key, beats, first, count, bins) != 0)
+    {
+        if (bins == NULL || score == NULL || from == NULL)
+            printf("Error allocating memory.\n");
+        arenaRelease(part->arena, bins);
+        arenaRelease(part->arena, score);
+        arenaRelease(part->arena, from);
+        return 1;
+    }
+
+    // -1 marks a chord that can't be there. ties go to the lower function
+    for (int j = 0; j < 7; j++)
+    {
+        int allowed = (before < 0) ? (j == 0) : allowedChordProgression(before, j);
+        score[0][j] = allowed ? bins[0][j] : -1;
+    }
+    for (int i = 1; i < count; i++)
+    {
+        for (int j = 0; j < 7; j++)
+        {
+            score[i][j] = -1;
+            for (int k = 0; k < 7; k++)
+            {
+                if (score[i - 1][k] >= 0 && allowedChordProgression(k, j) && score[i - 1][k] + bins[i][j] > score[i][j])
+                {
+                    score[i][j] = score[i - 1][k] + bins[i][j];
+                    from[i][j] = k;
+                }
+            }
+        }
+    }
+    int chord = -1;
+    for (int j = 0; j < 7; j++)
+    {
+        int allowed = (after < 0) ? (j == 0) : allowedChordProgression(j, after);
+        if (allowed && score[count - 1][j] >= 0 && (chord < 0 || score[count - 1][j] > score[count - 1][chord]))
+            chord = j;
+    }
+
+    // read the chords back from the last
+    for (int i = count - 1; chord >= 0 && i >= 0; i--)
+    {
+        harmony->function[first + i] = chord + 1;
+        harmony->type_id[first + i] = diatonic_types[chord];
+        harmony->inversion[first + i] = 0;
+        if (i > 0)
+            chord = from[i][chord];
+    }
+
+    arenaRelease(part->arena, bins);
+    arenaRelease(part->arena, score);
+    arenaRelease(part->arena, from);
+    return 0;
+}
+
+/**
+*   Brings a harmonization up to date after notes first_note to last_note of the melody,
+*   parts[0], changed pitch or became rests or notes. Durations must not change.
+*   Returns 0, or 1 on error
+**/
+int reharmonizeTimeline(Timeline* parts[], int num_parts, ChordTimeline* harmony, Timeline* rhythm, int key, int beats, int first_note, int last_note, Rng* rng, EditRange* edit)
+{
+    // error checking
+    if (parts == NULL || parts[0] == NULL || harmony == NULL || rhythm == NULL || rhythm->length == 0)
+    {
+        printf("Error reharmonizing: no melody, harmony or rhythm\n");
+        return 1;
+    }
+    if (harmony->length != rhythm->length)
+    {
+        printf("Error reharmonizing: the harmony doesn't follow the rhythm\n");
+        return 1;
+    }
+    for (int p = 1; p < num_parts; p++)
+    {
+        if (parts[p] == NULL || parts[p]->length != rhythm->length)
+        {
+            printf("Error reharmonizing: the parts don't follow the rhythm\n");
+            return 1;
+        }
+    }
+    Timeline* melody = parts[0];
+    if (first_note < 0 || last_note < first_note || last_note >= melody->length)
+    {
+        printf("Error reharmonizing: notes out of range\n");
+        return 1;
+    }
+
+    // the nodes the changed notes start in, and a few either side to fit them in
+    int start = melody->onset[first_note];
+    int end = melody->onset[last_note] + melody->duration[last_note];
+    int first = timelineIndexAt(rhythm, start);
+    int last = timelineIndexAt(rhythm, end - 1);
+    if (first < 0 || last < 0)
+    {
+        printf("Error: Rhythm is not as long as the part\n");
+        return 1;
+    }
+    first = (first > EDIT_CONTEXT) ? first - EDIT_CONTEXT : 0;
+    last = (last + EDIT_CONTEXT < rhythm->length - 1) ? last + EDIT_CONTEXT : rhythm->length - 1;
+    if (reharmonizeNodes(melody, rhythm, harmony, key, beats, first, last) != 0)
+        return 1;
+
+    // write each voice again from the first node. past the last node the chords and the
+    // parts above are as they were, so once a voice lands on its old note again the rest
+    // of it still fits. the voices below have to go at least as far as it did. a voice
+    // that hasn't met its old line by the end of the measure after the edit is led back
+    // to it: at the first node from there whose next old note is one it may play, and
+    // whose note nearest that is less than an octave from both neighbours, it takes that
+    // note and stops
+    int div_max = beats * DIVISIONS;
+    int limit_division = ((rhythm->onset[last] + rhythm->duration[last] - 1) / div_max + 2) * div_max;
+    int limit = last;
+    while (limit + 1 < rhythm->length && rhythm->onset[limit + 1] < limit_division)
+        limit++;
+    int changed = last;
+    for (int p = 1; p < num_parts; p++)
+    {
+        Timeline* voice = parts[p];
+        TimelineCursor part_cursor[p];
+        for (int i = 0; i < p; i++)
+            part_cursor[i] = cursorAt(parts[i], rhythm->onset[first]);
+        int previous_note = (first > 0) ? voice->note_num[first - 1] : 28 + norm_from_C[key + 7];
+
+        int until = changed;
+        for (int n = first; n < rhythm->length; n++)
+        {
+            int note_num = counterpointNote(harmony, n, parts, part_cursor, p, rhythm->onset[n], key, previous_note, rng);
+            if (n > until && note_num == voice->note_num[n])
+                break;
+
+            // a next old note that isn't one it may play was held from the one before, and
+            // a leap of an octave or more is never taken, so go on
+            int resolve = 0;
+            if (n >= limit && n >= until && n + 1 < rhythm->length)
+            {
+                Range range = counterpointRange(harmony, n, parts, part_cursor, p, rhythm->onset[n], key);
+                Range next_range = counterpointRange(harmony, n + 1, parts, part_cursor, p, rhythm->onset[n + 1], key);
+                int next_note = voice->note_num[n + 1];
+                int nearest = nearestNote(range, next_note, note_num);
+                resolve = isInRange(next_range, next_note) && abs(nearest - previous_note) < 12 &&
+                        abs(next_note - nearest) < 12;
+                if (resolve)
+                    note_num = nearest;
+            }
+            voice->note_num[n] = note_num;
+            previous_note = note_num;
+            if (n > changed)
+                changed = n;
+            if (resolve)
+                break;
+        }
+    }
+
+    // the measures that hold those nodes
+    if (edit != NULL)
+    {
+        edit->first_node = first;
+        edit->last_node = changed;
+        edit->first_measure = rhythm->onset[first] / div_max + 1;
+        edit->last_measure = (rhythm->onset[changed] + rhythm->duration[changed] - 1) / div_max + 1;
+    }
+    return 0;
+}
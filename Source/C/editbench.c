@@ -0,0 +1,181 @@
+/********************************************************************************
+ *
+ * Edit benchmark
+ *
+ * Harmonizes a random melody in four parts, then changes a few notes of it at
+ * a time and brings the harmonization up to date with reharmonizeTimeline().
+ * After every edit it checks that the progression is allowed from end to end,
+ * that every voice plays a note it may play without leaping an octave, and that
+ * nothing changed outside the nodes and measures the edit reports. Reports the
+ * time an edit takes against a whole new harmonization, and the most nodes an
+ * edit went past the measure after it, for each harmonic rhythm. Exits with 1 if
+ * a check fails.
+ *
+ *  usage: editbench [# notes] [# edits]
+ *
+********************************************************************************/
+
+#include "musicxml.h"
+
+#define BENCH_LOW_KEY 40
+#define BENCH_KEYS 20
+#define BENCH_PARTS 4
+#define BENCH_BEATS 4
+
+int checkHarmonization(Timeline* parts[], ChordTimeline* harmony, Timeline* rhythm);
+
+int main(int argc, char* argv[])
+{
+    int num_notes = (argc > 1) ? atoi(argv[1]) : 10000;
+    int num_edits = (argc > 2) ? atoi(argv[2]) : 200;
+    if (num_notes < 1 || num_edits < 1)
+    {
+        printf("USAGE: editbench [# notes] [# edits]\n");
+        return 1;
+    }
+
+    int durations[8] = {48, 96, 96, 192, 72, 24, 144, 384};
+    int div_max = BENCH_BEATS * DIVISIONS;
+    printf("%d notes, %d edits of 1 to 3 notes\n", num_notes, num_edits);
+    printf("rhythm   nodes  nodes/edit  past cap  us/edit  us/full\n");
+    for (int style = 0; style < 4; style++)
+    {
+        Arena* arena = arenaAlloc();
+        Rng rng = rngOf(style + 1);
+        Timeline* melody = (arena != NULL) ? timelineAlloc(num_notes, arena) : NULL;
+        if (melody == NULL)
+        {
+            printf("Error setting up the benchmark\n");
+            return 1;
+        }
+        for (int i = 0; i < num_notes; i++)
+            timelineAppend(melody, BENCH_LOW_KEY + rngBelow(&rng, BENCH_KEYS),
+                    durations[rngBelow(&rng, 8)], 1, rngBelow(&rng, 20) == 0);
+
+        // the harmonic rhythms import offers
+        int total_duration = timelineDuration(melody);
+        Timeline* rhythm = (style < 3) ? getRhythmTimeline(total_duration, 4 - style, 0, arena)
+                : copyTimelineRhythm(melody);
+
+        // a whole harmonization, timed
+        double start = searchClock();
+        ChordTimeline* harmony = determineHarmonyTimeline(melody, rhythm, 0, BENCH_BEATS);
+        Timeline* parts[BENCH_PARTS] = {melody};
+        for (int i = 1; i < BENCH_PARTS && harmony != NULL; i++)
+            parts[i] = getCounterpointTimeline(harmony, rhythm, parts, i, 0, 2, &rng);
+        double full = searchClock() - start;
+        if (harmony == NULL || parts[BENCH_PARTS - 1] == NULL || !checkHarmonization(parts, harmony, rhythm))
+        {
+            printf("Error: the harmonization to start from is wrong\n");
+            return 1;
+        }
+
+        int old_function[rhythm->length];
+        int old_note[BENCH_PARTS][rhythm->length];
+        double elapsed = 0;
+        long nodes = 0;
+        int past_cap = 0;
+        for (int e = 0; e < num_edits; e++)
+        {
+            for (int n = 0; n < rhythm->length; n++)
+            {
+                old_function[n] = harmony->function[n];
+                for (int p = 1; p < BENCH_PARTS; p++)
+                    old_note[p][n] = parts[p]->note_num[n];
+            }
+
+            // change one to three notes
+            int first_note = rngBelow(&rng, num_notes);
+            int last_note = first_note + rngBelow(&rng, 3);
+            if (last_note >= num_notes)
+                last_note = num_notes - 1;
+            for (int i = first_note; i <= last_note; i++)
+            {
+                melody->note_num[i] = BENCH_LOW_KEY + rngBelow(&rng, BENCH_KEYS);
+                melody->rest[i] = (rngBelow(&rng, 10) == 0);
+            }
+
+            EditRange edit;
+            start = searchClock();
+            int status = reharmonizeTimeline(parts, BENCH_PARTS, harmony, rhythm, 0, BENCH_BEATS,
+                    first_note, last_note, &rng, &edit);
+            elapsed += searchClock() - start;
+            nodes += edit.last_node - edit.first_node + 1;
+            if (status != 0 || !checkHarmonization(parts, harmony, rhythm))
+            {
+                printf("Error: edit %d (notes %d to %d) left a wrong harmonization\n", e, first_note, last_note);
+                return 1;
+            }
+
+            // everything that changed is inside what the edit reports
+            for (int n = 0; n < rhythm->length; n++)
+            {
+                int changed = (old_function[n] != harmony->function[n]);
+                for (int p = 1; p < BENCH_PARTS; p++)
+                    changed |= (old_note[p][n] != parts[p]->note_num[n]);
+                int first_measure = rhythm->onset[n] / div_max + 1;
+                int last_measure = (rhythm->onset[n] + rhythm->duration[n] - 1) / div_max + 1;
+                if (changed && (n < edit.first_node || n > edit.last_node ||
+                        first_measure < edit.first_measure || last_measure > edit.last_measure))
+                {
+                    printf("Error: edit %d changed node %d outside what it reports\n", e, n);
+                    return 1;
+                }
+            }
+
+            // how far it went past the last node that starts in the measure after the nodes
+            // around the edit, to lead the voices back to their old lines
+            int limit = timelineIndexAt(rhythm, melody->onset[last_note] + melody->duration[last_note] - 1) + EDIT_CONTEXT;
+            if (limit > rhythm->length - 1)
+                limit = rhythm->length - 1;
+            int limit_division = ((rhythm->onset[limit] + rhythm->duration[limit] - 1) / div_max + 2) * div_max;
+            while (limit + 1 < rhythm->length && rhythm->onset[limit + 1] < limit_division)
+                limit++;
+            if (edit.last_node - limit > past_cap)
+                past_cap = edit.last_node - limit;
+        }
+
+        char* names[4] = {"4 beats", "3 beats", "2 beats", "melody"};
+        printf("%-8s %6d %11.1f %9d %8.1f %8.1f\n", names[style], rhythm->length, (double) nodes / num_edits,
+                past_cap, 1e6 * elapsed / num_edits, 1e6 * full);
+        arenaFree(arena);
+    }
+
+    return 0;
+}
+
+/**
+*   Returns 1 if the harmony goes from tonic to tonic by allowed steps and each voice
+*   plays a note of its counterpointRange(), where one is near, less than an octave from
+*   the one before. 0 if not
+**/
+int checkHarmonization(Timeline* parts[], ChordTimeline* harmony, Timeline* rhythm)
+{
+    if (harmony->function[0] != 1 || harmony->function[harmony->length - 1] != 1)
+        return 0;
+    for (int i = 1; i < harmony->length; i++)
+        if (!allowedChordProgression(harmony->function[i - 1] - 1, harmony->function[i] - 1))
+            return 0;
+
+    for (int p = 1; p < BENCH_PARTS; p++)
+    {
+        TimelineCursor part_cursor[p];
+        for (int i = 0; i < p; i++)
+            part_cursor[i] = timelineCursor(parts[i]);
+        int previous_note = 28 + norm_from_C[0 + 7];
+        for (int n = 0; n < rhythm->length; n++)
+        {
+            Range allowed = counterpointRange(harmony, n, parts, part_cursor, p, rhythm->onset[n], 0);
+            int note_num = parts[p]->note_num[n];
+            int up = rangeAbove(allowed, previous_note);
+            int down = rangeBelow(allowed, previous_note);
+            int near = (up != 0 && up - previous_note < 12) || (down != 0 && previous_note - down < 12);
+            if (!isInRange(allowed, note_num) && near)
+                return 0;
+            if (abs(note_num - previous_note) >= 12)
+                return 0;
+            previous_note = note_num;
+        }
+    }
+    return 1;
+}
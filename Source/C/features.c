@@ -0,0 +1,356 @@
+/********************************************************************************
+ *
+ * Feature Store
+ *
+ *  © Phil Ngo, Tyler Clites 2012
+ *
+ * Keeps the frequency content of a recording in a compact way, so that it can
+ * be turned into notes again (with another onset threshold, or another way of
+ * picking keys) without reading the audio or running a single fft.
+ *
+ * A feature store holds, in this machine's byte order:
+ *      FEATURES_MAGIC
+ *      int32 sample rate, samples per channel, number of averages, number of frames
+ *      the averages read() finds onsets in, as doubles
+ *      one FeatureFrame for every FEATURE_HOP samples
+ *
+********************************************************************************/
+
+#include "musicxml.h"
+
+/**
+*   Computes the features of a whole recording, a frame every FEATURE_HOP samples,
+*   on a pool of threads, and writes them to a file along with the averages.
+*   Returns 0 on success, 1 on error.
+**/
+int storeFeatures(const char* filename, char* wavfile, wavFileInfo* info, double avg[], int num_avg, int num_threads)
+{
+    FeatureStore store;
+    store.sample_rate = info->sample_rate;
+    store.num_samples = info->subchunk2_size / (info->num_channels * sizeof(int16_t));
+    store.num_avg = num_avg;
+    store.avg = avg;
+    store.num_frames = (store.num_samples + FEATURE_HOP - 1) / FEATURE_HOP;
+    store.frames = calloc(store.num_frames, sizeof(FeatureFrame));
+    if (store.frames == NULL)
+        return 1;
+
+    // each thread gets a run of frames of its own
+    if (num_threads <= 0)
+        num_threads = numProcessors();
+    if (num_threads > store.num_frames)
+        num_threads = store.num_frames;
+    if (num_threads < 1)
+        num_threads = 1;
+    FeatureChunk chunks[num_threads];
+    void* args[num_threads];
+    for (int i = 0; i < num_threads; i++)
+    {
+        chunks[i].wavfile = wavfile;
+        chunks[i].info = info;
+        chunks[i].frames = store.frames;
+        chunks[i].first = (long) store.num_frames * i / num_threads;
+        chunks[i].count = (long) store.num_frames * (i + 1) / num_threads - chunks[i].first;
+        chunks[i].num_samples = store.num_samples;
+        chunks[i].error = 0;
+        args[i] = &chunks[i];
+    }
+    runThreads(num_threads, computeFeatures, args);
+
+    int error = 0;
+    for (int i = 0; i < num_threads; i++)
+        error |= chunks[i].error;
+
+    FILE* fp = (error) ? NULL : fopen(filename, "wb");
+    if (fp == NULL)
+    {
+        free(store.frames);
+        return 1;
+    }
+    int32_t header[4] = {store.sample_rate, store.num_samples, store.num_avg, store.num_frames};
+    error = (fwrite(FEATURES_MAGIC, 1, 4, fp) != 4
+            || fwrite(header, sizeof(int32_t), 4, fp) != 4
+            || fwrite(store.avg, sizeof(double), store.num_avg, fp) != (size_t) store.num_avg
+            || fwrite(store.frames, sizeof(FeatureFrame), store.num_frames, fp) != (size_t) store.num_frames);
+    if (fclose(fp) != 0)
+        error = 1;
+
+    free(store.frames);
+    return error;
+}
+
+/**
+*   Thread body for storeFeatures(): computes one FeatureChunk with its own handle
+*   on the file, its own buffer and its own fft plan. The last frames run past the
+*   end of the recording and are zero padded.
+**/
+void* computeFeatures(void* chunk)
+{
+    FeatureChunk* c = chunk;
+    wavFileInfo info = *c->info;
+    info.fp = fopen(c->wavfile, "r");
+    float* data = malloc(sizeof(float) * FEATURE_FRAME);
+    FFTPlan plan = {0};
+    if (info.fp == NULL || data == NULL)
+    {
+        c->error = 1;
+        if (info.fp != NULL)
+            fclose(info.fp);
+        free(data);
+        return NULL;
+    }
+
+    for (int f = c->first; f < c->first + c->count && !c->error; f++)
+    {
+        FeatureFrame* frame = &c->frames[f];
+        frame->start = f * FEATURE_HOP;
+        int count = (frame->start + FEATURE_FRAME < c->num_samples) ? FEATURE_FRAME : c->num_samples - frame->start;
+
+        // same offset as the notes, so frames and notes line up
+        for (int i = 0; i < FEATURE_FRAME; i++)
+            data[i] = 0;
+        fseek(info.fp, 36 + (frame->start * info.num_channels * sizeof(int16_t)), SEEK_SET);
+        makeWindow(&info, data, NULL, count);
+
+        if (frameFeatures(data, &plan, info.sample_rate, frame) != 0)
+            c->error = 1;
+    }
+
+    fclose(info.fp);
+    fftPlanFree(&plan);
+    free(data);
+    return NULL;
+}
+
+/**
+*   Fills in the features of one frame: the energy of its hann-windowed spectrum
+*   nearest each key, and its strongest peaks, placed between bins by fitting a
+*   parabola through each peak and its neighbours. data is overwritten.
+*   Returns 0 on success, -1 on error.
+**/
+int frameFeatures(float data[], FFTPlan* plan, int sample_rate, FeatureFrame* frame)
+{
+    int n = FEATURE_FRAME;
+    for (int i = 0; i < n; i++)
+        data[i] *= .5 - .5 * cos(2 * M_PI * i / n);
+    if (magnitudeSpectrum(data, n, plan) != 0)
+        return -1;
+
+    double bin_width = sample_rate / (double) n;
+    for (int k = 0; k < 88; k++)
+        frame->energy[k] = 0;
+    for (int p = 0; p < FEATURE_PEAKS; p++)
+    {
+        frame->frequency[p] = 0;
+        frame->magnitude[p] = 0;
+    }
+
+    for (int b = 1; b < n / 2; b++)
+    {
+        int key_number = keyOf(b * bin_width);
+        if (key_number > 0)
+            frame->energy[key_number - 1] += data[b] * data[b];
+
+        // keep the peak if it beats the weakest one kept so far, in order of strength
+        if (data[b] <= data[b - 1] || data[b] < data[b + 1] || data[b] <= frame->magnitude[FEATURE_PEAKS - 1])
+            continue;
+        float left = data[b - 1];
+        float right = data[b + 1];
+        float curve = left - 2 * data[b] + right;
+        float shift = (curve < 0) ? .5 * (left - right) / curve : 0;
+
+        int p = FEATURE_PEAKS - 1;
+        while (p > 0 && frame->magnitude[p - 1] < data[b])
+        {
+            frame->frequency[p] = frame->frequency[p - 1];
+            frame->magnitude[p] = frame->magnitude[p - 1];
+            p--;
+        }
+        frame->frequency[p] = (b + shift) * bin_width;
+        frame->magnitude[p] = data[b];
+    }
+    return 0;
+}
+
+/**
+*   Reads a feature store written by storeFeatures().
+*   Returns NULL if the file can't be read or isn't a feature store.
+**/
+FeatureStore* readFeatures(const char* filename)
+{
+    FILE* fp = fopen(filename, "rb");
+    if (fp == NULL)
+        return NULL;
+
+    char magic[4];
+    int32_t header[4];
+    if (fread(magic, 1, 4, fp) != 4 || memcmp(magic, FEATURES_MAGIC, 4) != 0
+            || fread(header, sizeof(int32_t), 4, fp) != 4 || header[2] < 0 || header[3] < 0)
+    {
+        fclose(fp);
+        return NULL;
+    }
+
+    FeatureStore* store = malloc(sizeof(FeatureStore));
+    if (store == NULL)
+    {
+        fclose(fp);
+        return NULL;
+    }
+    store->sample_rate = header[0];
+    store->num_samples = header[1];
+    store->num_avg = header[2];
+    store->num_frames = header[3];
+
+    // one spare of each, so an empty store still gets memory
+    store->avg = malloc(sizeof(double) * (store->num_avg + 1));
+    store->frames = malloc(sizeof(FeatureFrame) * (store->num_frames + 1));
+    if (store->avg == NULL || store->frames == NULL
+            || fread(store->avg, sizeof(double), store->num_avg, fp) != (size_t) store->num_avg
+            || fread(store->frames, sizeof(FeatureFrame), store->num_frames, fp) != (size_t) store->num_frames)
+    {
+        fclose(fp);
+        freeFeatures(store);
+        return NULL;
+    }
+
+    fclose(fp);
+    return store;
+}
+
+/**
+*   Frees a store from readFeatures()
+**/
+int freeFeatures(FeatureStore* store)
+{
+    if (store == NULL)
+        return 0;
+    free(store->avg);
+    free(store->frames);
+    free(store);
+    return 0;
+}
+
+/**
+*   Key number of a stretch of the recording, from the frames centered inside it
+*   (or the nearest frame, for a stretch shorter than a hop).
+*   For the fft engine, decides like analyzeData: the key of the strongest peak,
+*   moved to the lowest octave that the NUMMAX strongest peaks reach.
+*   For any other engine, the key whose harmonics hold the most energy.
+*   Returns -1 on error.
+**/
+int featureKey(FeatureStore* store, int start, int length, int engine)
+{
+    if (store->num_frames == 0)
+        return 0;
+
+    // frames with their centers in [start, start + length)
+    int first = (start - FEATURE_FRAME / 2 + FEATURE_HOP - 1) / FEATURE_HOP;
+    if (first < 0)
+        first = 0;
+    int last = (start + length - 1 - FEATURE_FRAME / 2) / FEATURE_HOP;
+    if (start + length - 1 - FEATURE_FRAME / 2 < 0)
+        last = -1;
+    if (last >= store->num_frames)
+        last = store->num_frames - 1;
+    if (first > last)
+    {
+        first = (start + length / 2 - FEATURE_FRAME / 2) / FEATURE_HOP;
+        if (first >= store->num_frames)
+            first = store->num_frames - 1;
+        if (first < 0)
+            first = 0;
+        last = first;
+    }
+
+    if (engine != ENGINE_FFT)
+    {
+        double energy[88] = {0};
+        for (int f = first; f <= last; f++)
+            for (int k = 0; k < 88; k++)
+                energy[k] += store->frames[f].energy[k];
+        return keyOfEnergies(energy);
+    }
+
+    // the NUMMAX strongest peaks of all the frames, picked like analyzeData picks bins
+    int num_peaks = (last - first + 1) * FEATURE_PEAKS;
+    float* magnitude = malloc(sizeof(float) * num_peaks);
+    gsl_histogram* h = gsl_histogram_alloc(88);
+    if (magnitude == NULL || h == NULL)
+    {
+        free(magnitude);
+        if (h != NULL)
+            gsl_histogram_free(h);
+        return -1;
+    }
+    double range[89];
+    for (int i = 0; i < 88; i++)
+        range[i] = (pow(2.0, ((i + .5) - 49) / 12.0) * 440.0);
+    range[88] = 10000;
+    gsl_histogram_set_ranges(h, range, 89);
+
+    for (int f = first; f <= last; f++)
+        for (int p = 0; p < FEATURE_PEAKS; p++)
+            magnitude[(f - first) * FEATURE_PEAKS + p] = store->frames[f].magnitude[p];
+
+    int max_key_number = 0;
+    for (int j = 0; j < NUMMAX && j < num_peaks; j++)
+    {
+        int idx = 0;
+        for (int i = 1; i < num_peaks; i++)
+            if (magnitude[i] > magnitude[idx])
+                idx = i;
+        if (magnitude[idx] <= 0)
+            break;
+
+        float frequency = store->frames[first + idx / FEATURE_PEAKS].frequency[idx % FEATURE_PEAKS];
+        if (j == 0)
+        {
+            max_key_number = round(12 * log2f(frequency / 440) + 49);
+            if (max_key_number < 0 || max_key_number > 88)
+                max_key_number = 0;
+        }
+        gsl_histogram_increment(h, frequency);
+        magnitude[idx] = 0;
+    }
+
+    int key_number = max_key_number + findClumps(h, max_key_number);
+    gsl_histogram_free(h);
+    free(magnitude);
+    return key_number;
+}
+
+/**
+*   Like read(), but from a feature store instead of the audio. Finds the onsets in
+*   the stored averages with settings.threshold_factor and picks each note's key
+*   from its frames with featureKey(), so no wav file is read and no fft is run.
+**/
+Part* reanalyze(const char* filename, int bpm, int divspermeasure, AnalysisSettings settings)
+{
+    FeatureStore* store = readFeatures(filename);
+    if (store == NULL)
+    {
+        printf("Error reading feature store.\n");
+        return NULL;
+    }
+
+    // same onsets read() would find
+    int skip = (store->sample_rate / (4 * bpm / 60)) / AVG_WINDOW - 1;
+    double threshold_factor = (settings.threshold_factor > 0) ? settings.threshold_factor : THRESHOLD_FACTOR;
+    int num_jobs = 0;
+    NoteJob* jobs = findNotes(store->avg, store->num_avg, threshold_factor, skip, &num_jobs);
+    if (jobs == NULL)
+    {
+        printf("Error: no notes found.\n");
+        freeFeatures(store);
+        return NULL;
+    }
+
+    for (int j = 0; j < num_jobs; j++)
+        jobs[j].key_number = featureKey(store, jobs[j].start, jobs[j].length, settings.engine);
+
+    Part* head = assembleNotes(jobs, num_jobs, bpm, store->sample_rate, divspermeasure, settings.arena);
+    freeFeatures(store);
+    free(jobs);
+    return head;
+}
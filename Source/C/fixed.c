@@ -0,0 +1,304 @@
+/********************************************************************************
+ *
+ * Fixed-Point Analysis
+ *
+ *  © Phil Ngo, Tyler Clites 2012
+ *
+ * read() for the appliance build (make fixed in Appliance/, -DFIXED_POINT), which
+ * has no gsl and little memory. From the samples to the key numbers it is all
+ * integer math:
+ *      1) the envelope is kept as int32 sums of AVG_WINDOW absolute samples,
+ *         which gives exactly the onsets, and so the durations, of the float path.
+ *      2) each note is streamed from the file through a Q28 goertzel filter bank
+ *         in blocks of int16 samples, so no note is ever held in memory.
+ *      3) the key is picked from the int64 energies the way keyOfEnergies does.
+ * The keys are those of the float goertzel engine (--engine=goertzel), except
+ * where its two best keys are within rounding of each other. There is one
+ * engine, no threads, no diagnostics and no feature store.
+ *
+********************************************************************************/
+
+#include "musicxml.h"
+
+#ifndef FIXED_POINT
+#error "fixed.c is only for the FIXED_POINT build"
+#endif
+
+Part* read(char* wavfile, int bpm, int divspermeasure, AnalysisSettings settings)
+{
+    // the fft engine is the default, the goertzel bank stands in for it
+    if (settings.engine != ENGINE_FFT && settings.engine != ENGINE_GOERTZEL)
+    {
+        printf("Error: the fixed-point build only has the goertzel engine.\n");
+        return NULL;
+    }
+
+    // open files
+    wavFileInfo info;
+    info.fp = fopen(wavfile, "r");
+    if (info.fp == NULL)
+    {
+        printf("Error opening WAVE file.\n");
+        return NULL;
+    }
+
+    if (openWavFile(&info) != 0)
+    {
+        printf("Error reading WAVE file.\n");
+        fclose(info.fp);
+        return NULL;
+    }
+
+    // Compatibility Check
+    if (info.bits_per_sample != 16)
+    {
+        printf("Error: Only 16-bit samples supported.\n");
+        fclose(info.fp);
+        return NULL;
+    }
+
+    // find and store the sum of each [AVG_WINDOW] points
+    int num_avg = info.subchunk2_size / (AVG_WINDOW * sizeof(int16_t));
+    if (info.num_channels == 2)
+    {
+        num_avg /= 2;
+    }
+    int32_t* sums = malloc(sizeof(int32_t) * (num_avg + 1));
+    if (sums == NULL)
+    {
+        printf("Error allocating memory.\n");
+        fclose(info.fp);
+        return NULL;
+    }
+    findAvgsFixed(&info, sums, num_avg);
+
+    // split the recording at every onset, skipping ahead the length of a 16th note after each
+    int skip = (info.sample_rate / (4 * bpm / 60)) / AVG_WINDOW - 1;
+    double threshold_factor = (settings.threshold_factor > 0) ? settings.threshold_factor : THRESHOLD_FACTOR;
+    int num_jobs = 0;
+    NoteJob* jobs = findNotesFixed(sums, num_avg, round(threshold_factor * 1000), skip, &num_jobs);
+    free(sums);
+    if (jobs == NULL)
+    {
+        printf("Error: no notes found.\n");
+        fclose(info.fp);
+        return NULL;
+    }
+
+    // each note straight from the file through the filter bank
+    int64_t coeff[GOERTZEL_FILTERS];
+    int64_t energy[88];
+    goertzelCoefficientsFixed(info.sample_rate, coeff);
+    for (int j = 0; j < num_jobs; j++)
+    {
+        fseek(info.fp, 36 + (jobs[j].start * info.num_channels * sizeof(int16_t)), SEEK_SET);
+        goertzelEnergiesFixed(&info, coeff, jobs[j].length, energy);
+        jobs[j].key_number = keyOfEnergiesFixed(energy);
+    }
+
+    // create a singly linked-list of notes
+    Part* head = assembleNotes(jobs, num_jobs, bpm, info.sample_rate, divspermeasure, settings.arena);
+
+    // close the file
+    fclose(info.fp);
+    free(jobs);
+    return head;
+}
+
+/**
+*   Fills sums with the sum of the absolute value of each AVG_WINDOW samples of the
+*   left channel, findAvgs without the division. A sum is at most 300 * 32768.
+**/
+int findAvgsFixed(wavFileInfo* info, int32_t sums[], int num_avg)
+{
+    int16_t buffer[2 * AVG_WINDOW];
+    int channels = info->num_channels;
+
+    for (int pos = 0; pos < num_avg; pos++)
+    {
+        sums[pos] = 0;
+        if (fread(buffer, sizeof(int16_t) * channels, AVG_WINDOW, info->fp) != AVG_WINDOW)
+        {
+            for (int i = pos; i < num_avg; i++)
+                sums[i] = 0;
+            return 0;
+        }
+        for (int i = 0; i < AVG_WINDOW; i++)
+            sums[pos] += abs(buffer[i * channels]);
+    }
+    return 0;
+}
+
+/**
+*   findNotes() on the sums of findAvgsFixed. An onset is where the derivative of the
+*   averages, truncated like findNotes truncates it, reaches threshold_permille
+*   thousandths of the largest derivative. Compared in whole numbers of sums, that is
+*   |d / AVG_WINDOW| * AVG_WINDOW * 1000 >= largest d * threshold_permille.
+*   Returns the notes in order, NULL if there are none.
+**/
+NoteJob* findNotesFixed(int32_t sums[], int num_avg, int threshold_permille, int skip, int* num_jobs)
+{
+    NoteJob* jobs = NULL;
+    int capacity = 0;
+    *num_jobs = 0;
+    if (num_avg < 2)
+        return NULL;
+
+    // the largest derivative, signed like max() takes it
+    int64_t largest = sums[1] - sums[0];
+    for (int i = 1; i < num_avg - 1; i++)
+        if (sums[i + 1] - sums[i] > largest)
+            largest = sums[i + 1] - sums[i];
+    int64_t threshold = largest * threshold_permille;
+
+    for (int i = 0; i < num_avg - 1; i++)
+    {
+        int64_t step = abs(sums[i + 1] - sums[i]) / AVG_WINDOW;
+        if (step * AVG_WINDOW * 1000 >= threshold)
+        {
+            if (*num_jobs == capacity)
+            {
+                capacity = (capacity == 0) ? 64 : capacity * 2;
+                NoteJob* bigger = realloc(jobs, sizeof(NoteJob) * capacity);
+                if (bigger == NULL)
+                {
+                    printf("Error allocating memory for notes\n");
+                    free(jobs);
+                    *num_jobs = 0;
+                    return NULL;
+                }
+                jobs = bigger;
+            }
+            jobs[*num_jobs].start = i * AVG_WINDOW;
+            (*num_jobs)++;
+            i += skip;
+        }
+    }
+
+    // each note lasts until the next one starts, the last until the end of the file
+    for (int j = 0; j < *num_jobs; j++)
+    {
+        int end = (j + 1 < *num_jobs) ? jobs[j + 1].start : num_avg * AVG_WINDOW;
+        jobs[j].length = end - jobs[j].start;
+        jobs[j].size = jobs[j].length;
+        jobs[j].key_number = 0;
+        jobs[j].diagnostics = NULL;
+    }
+    return jobs;
+}
+
+/**
+*   Q28 coefficients (2 cos w) of the goertzel filters, the same filters goertzelEnergies uses.
+*   Worked out once per file, this is the only floating point on the fixed-point path.
+**/
+int goertzelCoefficientsFixed(int sample_rate, int64_t coeff[GOERTZEL_FILTERS])
+{
+    for (int i = 0; i < GOERTZEL_FILTERS; i++)
+    {
+        double offset = (i % GOERTZEL_PER_KEY) - (GOERTZEL_PER_KEY - 1) / 2.0;
+        double frequency = 440 * pow(2.0, (i / GOERTZEL_PER_KEY - 48 + offset / GOERTZEL_PER_KEY) / 12.0);
+        coeff[i] = llround(2 * cos(2 * M_PI * frequency / sample_rate) * (1 << FIXED_COEFF_BITS));
+    }
+    return 0;
+}
+
+/**
+*   Streams length samples of the left channel from the file's position through the
+*   goertzel filters, and fills energy[88] with each key's energy, in arbitrary units.
+*
+*   A state can grow to the block length times the largest input over sin w. With
+*   13-bit inputs and 4096-sample blocks that stays under 2^34 down to key 1 at
+*   48 kHz (higher rates get proportionally shorter blocks), so coeff * state fits
+*   in 63 bits. The states lose FIXED_STATE_SHIFT bits before they are squared, and
+*   each block's energy FIXED_ENERGY_SHIFT bits before it is added to the key's.
+**/
+int goertzelEnergiesFixed(wavFileInfo* info, int64_t coeff[GOERTZEL_FILTERS], int length, int64_t energy[88])
+{
+    int16_t buffer[2 * GOERTZEL_BLOCK];
+    int64_t s1[GOERTZEL_FILTERS];
+    int64_t s2[GOERTZEL_FILTERS];
+    int channels = info->num_channels;
+    int block = (info->sample_rate > 48000) ? (int64_t) GOERTZEL_BLOCK * 48000 / info->sample_rate : GOERTZEL_BLOCK;
+
+    for (int k = 0; k < 88; k++)
+        energy[k] = 0;
+
+    for (int start = 0; start < length; start += block)
+    {
+        int count = (start + block < length) ? block : length - start;
+        count = fread(buffer, sizeof(int16_t) * channels, count, info->fp);
+        if (count == 0)
+            break;
+        for (int i = 0; i < GOERTZEL_FILTERS; i++)
+        {
+            s1[i] = 0;
+            s2[i] = 0;
+        }
+
+        // s[n] = x[n] + coeff * s[n - 1] - s[n - 2], for every filter at once
+        for (int n = 0; n < count; n++)
+        {
+            int64_t x = buffer[n * channels] >> FIXED_INPUT_SHIFT;
+            for (int i = 0; i < GOERTZEL_FILTERS; i++)
+            {
+                int64_t s0 = x + ((coeff[i] * s1[i]) >> FIXED_COEFF_BITS) - s2[i];
+                s2[i] = s1[i];
+                s1[i] = s0;
+            }
+        }
+
+        // block energy s1^2 + s2^2 - coeff s1 s2, added to its key without overflowing
+        for (int i = 0; i < GOERTZEL_FILTERS; i++)
+        {
+            int64_t a = s1[i] >> FIXED_STATE_SHIFT;
+            int64_t b = s2[i] >> FIXED_STATE_SHIFT;
+            int64_t e = (a * a + b * b - ((coeff[i] * a) >> FIXED_COEFF_BITS) * b) >> FIXED_ENERGY_SHIFT;
+            int64_t* total = &energy[i / GOERTZEL_PER_KEY];
+            *total = (*total > INT64_MAX - e) ? INT64_MAX : *total + e;
+        }
+    }
+    return 0;
+}
+
+/**
+*   keyOfEnergies() for integer energies: the key whose harmonics hold the most
+*   energy, 0 if there is none. Each energy loses three bits so five of them can be summed.
+**/
+int keyOfEnergiesFixed(int64_t energy[88])
+{
+    int key_number = 0;
+    int64_t loudest = 0;
+
+    for (int k = 0; k < 88; k++)
+    {
+        int64_t sum = 0;
+        for (int h = 0; h < 5 && k + harmonic_offsets[h] < 88; h++)
+            sum += energy[k + harmonic_offsets[h]] >> 3;
+        if (sum > loudest)
+        {
+            loudest = sum;
+            key_number = k + 1;
+        }
+    }
+    return key_number;
+}
+
+/**
+*   The fixed-point build has only the goertzel bank, the other engines need gsl or floats.
+*   "fft" is still the default, and read() lets the goertzel bank stand in for it
+**/
+int engineOf(const char* name)
+{
+    if (strcmp(name, "fft") == 0)
+        return ENGINE_FFT;
+    return (strcmp(name, "goertzel") == 0) ? ENGINE_GOERTZEL : -1;
+}
+
+/**
+*   Feature stores are made of ffts, which the fixed-point build doesn't have
+**/
+Part* reanalyze(const char* filename, int bpm, int divspermeasure, AnalysisSettings settings)
+{
+    printf("Error: the fixed-point build has no feature store.\n");
+    return NULL;
+}
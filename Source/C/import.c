@@ -5,9 +5,14 @@ void parseString(char* string, char find, char replace);
 int main(int argc, char* argv[])
 {
     // usage
-    if (argc != 12)
+    if (argc < 12)
     {
-        printf("USAGE: import [input .wav] [output .xml] [key] [new key] [bpm] [meter] [pickup] [harmonic rhythm] [# parts] [composer] [title]\n");
+        printf("USAGE: import [input .wav] [output .xml] [key] [new key] [bpm] [meter] [pickup] [harmonic rhythm] [# parts] [composer] [title] [options]\n");
+        printf("OPTIONS: --engine=fft|yin|hps|goertzel|cqt|sdft --threads=N (default: one per processor) --diagnostics=[file]\n");
+        printf("         --features=[file] --threshold=[fraction] --reanalyze (input is a --features file)\n");
+        printf("         --alternatives=N (the N best harmonizations: [output].xml, [output]-2.xml ...)\n");
+        printf("         --search=N --search-seconds=S (draw harmonizations at random, keep the best of N or of S seconds)\n");
+        printf("         --seed=N (the same seed makes the same music, default: the time)\n");
         return 1;
     }
    
@@ -23,6 +28,42 @@ int main(int argc, char* argv[])
     char* composer = argv[10];
     char* title = argv[11];
     
+    // optional settings follow the required arguments
+    AnalysisSettings settings = {.engine = ENGINE_FFT, .num_threads = 0, .diagnostics = NULL,
+            .features = NULL, .threshold_factor = THRESHOLD_FACTOR, .arena = NULL};
+    int reanalysis = 0;
+    int alternatives = 1;
+    SearchSettings search = {.candidates = 0, .seconds = 0, .num_threads = 0, .seed = 0};
+    uint64_t seed = time(NULL);
+    for (int i = 12; i < argc; i++)
+    {
+        if (strncmp(argv[i], "--engine=", 9) == 0)
+            settings.engine = engineOf(&argv[i][9]);
+        else if (strncmp(argv[i], "--threads=", 10) == 0)
+            settings.num_threads = atoi(&argv[i][10]);
+        else if (strncmp(argv[i], "--diagnostics=", 14) == 0)
+            settings.diagnostics = &argv[i][14];
+        else if (strncmp(argv[i], "--features=", 11) == 0)
+            settings.features = &argv[i][11];
+        else if (strncmp(argv[i], "--threshold=", 12) == 0)
+            settings.threshold_factor = atof(&argv[i][12]);
+        else if (strcmp(argv[i], "--reanalyze") == 0)
+            reanalysis = 1;
+        else if (strncmp(argv[i], "--alternatives=", 15) == 0)
+            alternatives = atoi(&argv[i][15]);
+        else if (strncmp(argv[i], "--search=", 9) == 0)
+            search.candidates = atoi(&argv[i][9]);
+        else if (strncmp(argv[i], "--search-seconds=", 17) == 0)
+            search.seconds = atof(&argv[i][17]);
+        else if (strncmp(argv[i], "--seed=", 7) == 0)
+            seed = strtoull(&argv[i][7], NULL, 10);
+        else
+        {
+            printf("Error: unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
     // change underscore to space for the names and titles
     parseString(composer, '_', ' ');
     parseString(title, '_', ' ');
@@ -30,7 +71,8 @@ int main(int argc, char* argv[])
     // error checking
     int in_filename_length = strlen(in_file);
     int out_filename_length = strlen(out_file);
-    if (strcmp(&in_file[in_filename_length - 4], ".wav") != 0)
+    // a feature store may be named anything, reanalyze() checks that it is one
+    if (!reanalysis && (in_filename_length < 4 || strcmp(&in_file[in_filename_length - 4], ".wav") != 0))
     {
         printf("Error: input file format must be .wav\n");
         return 1;
@@ -65,91 +107,143 @@ int main(int argc, char* argv[])
         printf("Error: unsupported number of parts\n");
         return 1;
     }
+    if (settings.num_threads < 0 || settings.num_threads > MAX_THREADS)
+    {
+        printf("Error: unsupported number of threads\n");
+        return 1;
+    }
+    if (settings.engine == -1)
+    {
+        printf("Error: unsupported pitch engine\n");
+        return 1;
+    }
+    if (alternatives < 1 || alternatives > 100)
+    {
+        printf("Error: unsupported number of alternatives\n");
+        return 1;
+    }
+    if (search.candidates < 0 || search.seconds < 0)
+    {
+        printf("Error: unsupported search budget\n");
+        return 1;
+    }
+    int searching = (search.candidates > 0 || search.seconds > 0);
+    if (searching && alternatives > 1)
+    {
+        printf("Error: a search keeps one harmonization, it can't be given alternatives\n");
+        return 1;
+    }
+    search.num_threads = settings.num_threads;
+    search.seed = seed;
+
+    // everything chosen at random comes from here
+    Rng rng = rngOf(seed);
+
+    // everything the run makes comes from one arena, and goes with it at the end
+    Arena* arena = arenaAlloc();
+    if (arena == NULL)
+    {
+        printf("Error allocating memory\n");
+        return 1;
+    }
+    settings.arena = arena;
 
-    // import a part from tyler
-    Part* melody = read(argv[1], bpm, beats * DIVISIONS / NOTESCALEFACTOR);
+    // import a part from tyler, and lay it out as a timeline
+    Part* notes = (reanalysis) ? reanalyze(argv[1], bpm, beats * DIVISIONS / NOTESCALEFACTOR, settings)
+            : read(argv[1], bpm, beats * DIVISIONS / NOTESCALEFACTOR, settings);
+    Timeline* melody = (notes != NULL) ? timelineOfPart(notes, arena) : NULL;
     if (melody == NULL)
     {
         printf("Error importing melody\n");
+        arenaFree(arena);
         return 1;
     }
 
     // see what meter it's in. this is not used now, but can be used in the future.
-    int* meter_attributes = determineMeter(melody);
+    int* meter_attributes = determineMeterTimeline(melody);
     if (meter_attributes == 0)
     {
         printf("Error determining the meter of the melody\n");
-        rmPart(melody);
+        arenaFree(arena);
         return 1;
     }
 
     // offset the start with a pickup measure
-    melody = addPickup(melody, pickup, beats);
+    addPickupTimeline(melody, pickup, beats);
 
     // transpose to c to make things easy
-    transpose(melody, key, 0, -1);
+    transposeTimeline(melody, key, 0, -1);
 
     // see how long the melody is
-    int total_duration = 0;
-    Part* melody_ptr = melody;
-    while (melody_ptr != NULL)
-    {
-        total_duration += melody_ptr->duration;
-        melody_ptr = melody_ptr->next;
-    }
+    int total_duration = timelineDuration(melody);
 
     // These are the options for writing harmonic rhythms.
-    Rhythm* rhythm[4];
-    rhythm[0] = getRhythm(total_duration, 4, 0);
-    rhythm[1] = getRhythm(total_duration, 3, 0);
-    rhythm[2] = getRhythm(total_duration, 2, 0);
-    rhythm[3] = copyPartRhythm(melody);
+    Timeline* rhythm[4];
+    rhythm[0] = getRhythmTimeline(total_duration, 4, 0, arena);
+    rhythm[1] = getRhythmTimeline(total_duration, 3, 0, arena);
+    rhythm[2] = getRhythmTimeline(total_duration, 2, 0, arena);
+    rhythm[3] = copyTimelineRhythm(melody);
 
-    // determine a harmony
-    Harmony* my_harmony = determineHarmony(melody, rhythm[harmonic_rhythm], 0, beats);
-    if (my_harmony == NULL)
+    // determine the best harmonies, from one search. or draw harmonizations, harmonies and
+    // parts together, and keep the one that costs least
+    ChordTimeline* harmonies[alternatives];
+    int scores[alternatives];
+    Timeline* parts[alternatives][num_parts];
+    int found;
+    if (searching)
+    {
+        int tried = 0;
+        scores[0] = searchHarmonization(melody, rhythm[harmonic_rhythm], 0, beats, num_parts, search, &harmonies[0], parts[0], &tried);
+        found = (scores[0] >= 0) ? 1 : 0;
+        if (found)
+            printf("Search: the best of %d harmonizations costs %d\n", tried, scores[0]);
+    }
+    else
+        found = determineHarmoniesTimeline(melody, rhythm[harmonic_rhythm], 0, beats, harmonies, scores, alternatives);
+    if (found < 1)
     {
         printf("Error writing imported harmony\n");
-        rmPart(melody);
-        for (int i = 0; i < 4; i++)
-            rmRhythm(rhythm[i]);
+        arenaFree(arena);
         return 1;
     }
 
-    // figure out the other parts
-    Part* parts[num_parts];
-    parts[0] = melody;
-    for (int i = 1; i < num_parts; i++)
-        parts[i] = getCounterpointPart(my_harmony, rhythm[harmonic_rhythm], parts, i, 0, 2);
-
-    // make sure the parts were created correctly
-    for (int i = 0; i < num_parts; i++)
+    // figure out the other parts of each harmonization, making sure each was created correctly
+    for (int a = 0; a < found && !searching; a++)
     {
-        if (parts[i] == NULL)
+        parts[a][0] = melody;
+        for (int i = 1; i < num_parts; i++)
         {
-            printf("Error writing harmony parts\n");
-            for (int j = 0; j < i; j++)
-                rmPart(parts[i]);
-            for (int j = 0; j < 4; j++)
-                rmRhythm(rhythm[i]);
-            rmHarmony(my_harmony);
-            return 1;
+            parts[a][i] = getCounterpointTimeline(harmonies[a], rhythm[harmonic_rhythm], parts[a], i, 0, 2, &rng);
+            if (parts[a][i] == NULL)
+            {
+                printf("Error writing harmony parts\n");
+                arenaFree(arena);
+                return 1;
+            }
         }
     }
 
-    // transpose to desired key
-    for (int i = 0; i < num_parts; i++)
-        transpose(parts[i], 0, new_key, 1);
+    // transpose to desired key. the melody is shared by all of them
+    transposeTimeline(melody, 0, new_key, 1);
+    for (int a = 0; a < found; a++)
+        for (int i = 1; i < num_parts; i++)
+            transposeTimeline(parts[a][i], 0, new_key, 1);
 
-    // write the part to file
-    writePart(out_file, parts, num_parts, beats, new_key, composer, title);
+    // write each harmonization to file, the best to out_file and the others numbered after it
+    for (int a = 0; a < found; a++)
+    {
+        char alternative_file[out_filename_length + MAX_STRING];
+        if (a == 0)
+            strcpy(alternative_file, out_file);
+        else
+            sprintf(alternative_file, "%.*s-%d.xml", out_filename_length - 4, out_file, a + 1);
+        if (found > 1)
+            printf("Harmonization %d (score %d): %s\n", a + 1, scores[a], alternative_file);
+        writeTimelines(alternative_file, parts[a], num_parts, beats, new_key, composer, title);
+    }
 
     // free memory
-    rmHarmony(my_harmony);
-    for (int i = 0; i < 4; i++)
-        rmRhythm(rhythm[i]);
-    for (int i = 0; i < num_parts; i++)
-        rmPart(parts[i]);
+    arenaFree(arena);
 
     // open up the result in finale notepad
     char* open = "open -a /Applications/Finale\\ NotePad\\ 2012.app ";
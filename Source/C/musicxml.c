@@ -22,9 +22,6 @@
 
 #include "musicxml.h"
 
-// used to randomize using system time.
-int global_seed = 1;
-
 /**
 *   Intoduce an offset for a pickup measure
 **/
@@ -48,20 +45,16 @@ Part* addPickup(Part* part, int beats, int meter)
 /**
 *   Follow these guidelines when choosing a chord
 *   Returns 1 if allowed, 0 if not allowed.
-*   arguments: takes two numbers from 0 to 6 inclusive
+*   arguments: takes two numbers from 0 to 6 inclusive, function - 1, anything else
+*   is not allowed
 **/
 int allowedChordProgression(int first, int second)
 {
-    // this matrix stores information about which chords can follow a given chord
-    int allowed_matrix[7][7] = {{1,1,1,1,1,1,1},
-                                {0,1,0,0,1,0,1},
-                                {0,1,1,1,0,1,0},
-                                {1,0,0,1,1,0,1},
-                                {1,0,0,0,1,1,0},
-                                {0,1,0,1,0,1,0},
-                                {1,0,0,0,0,0,1}};
-
-    return allowed_matrix[first][second];
+    if (first < 0 || first > 6 || second < 0 || second > 6)
+    {
+        return 0;
+    }
+    return allowed_progressions[first][second];
 }
 
 /**
@@ -82,6 +75,67 @@ int alterOf(char* note, int key)
     return 0;
 }
 
+/**
+*   Returns an empty composition with room for capacity sections, NULL if memory runs out
+**/
+Composition* compositionAlloc(int capacity)
+{
+    Composition* composition = malloc(sizeof(Composition));
+    if (composition == NULL)
+    {
+        return NULL;
+    }
+
+    if (capacity < 16)
+    {
+        capacity = 16;
+    }
+    composition->key = 0;
+    composition->length = 0;
+    composition->capacity = capacity;
+    composition->section = malloc(sizeof(Section) * capacity);
+    if (composition->section == NULL)
+    {
+        free(composition);
+        return NULL;
+    }
+    return composition;
+}
+
+/**
+*   Adds a section to the end of a composition, doubling its room when it runs out.
+*   Returns 0, or 1 if memory runs out
+**/
+int compositionAppend(Composition* composition, Section section)
+{
+    if (composition->length == composition->capacity)
+    {
+        Section* sections = realloc(composition->section, sizeof(Section) * composition->capacity * 2);
+        if (sections == NULL)
+        {
+            return 1;
+        }
+        composition->section = sections;
+        composition->capacity *= 2;
+    }
+    composition->section[composition->length++] = section;
+    return 0;
+}
+
+/**
+*   Frees a composition and its sections
+**/
+int compositionFree(Composition* composition)
+{
+    if (composition == NULL)
+    {
+        return 0;
+    }
+    free(composition->section);
+    free(composition);
+    return 0;
+}
+
 /**
 *   Returns a rhythm with the same rhythm as the part
 **/
@@ -94,24 +148,14 @@ Rhythm* copyPartRhythm(Part* part)
         return NULL;
     }
 
-    // declare a new head pointer
-    Rhythm* rhythm = malloc(sizeof(Rhythm));
-
-    // loop over part, copying the durations
-    Part* part_ptr = part;
-    Rhythm* rhythm_ptr = rhythm;
-    while (part_ptr != NULL)
+    // a rhythm is the durations of a timeline
+    Timeline* timeline = timelineOfPart(part, NULL);
+    if (timeline == NULL)
     {
-        rhythm_ptr->divisions = part_ptr->duration;
-        part_ptr = part_ptr->next;
-        if (part_ptr != NULL)
-        {
-            rhythm_ptr->next = malloc(sizeof(Rhythm));
-            rhythm_ptr = rhythm_ptr->next; 
-        }
-        else
-            rhythm_ptr->next = NULL;
+        return NULL;
     }
+    Rhythm* rhythm = rhythmOfTimeline(timeline);
+    timelineFree(timeline);
 
     // return the head pointer
     return rhythm;
@@ -123,11 +167,8 @@ Rhythm* copyPartRhythm(Part* part)
 *       2) chord progression starts on 1 and ends on 1
 *       3) length is somewhere bewteen 5 and 40 sections
 **/
-int createRandomInput(char* filename)
+int createRandomInput(char* filename, Rng* rng)
 {
-    // reseed to psuedo-randomize
-    srand(time(NULL) * global_seed++);
-    
     // try to open file to write to
     FILE* fp = fopen(filename, "w");
     if (fp == NULL)
@@ -137,8 +178,8 @@ int createRandomInput(char* filename)
     }
 
     // random key and length, random number of chords per measure
-    int key = (rand() % 15) - 7;
-    int num_measures = (rand() % 11) + 5;
+    int key = rngBelow(rng, 15) - 7;
+    int num_measures = rngBelow(rng, 11) + 5;
     int changes_per_measure = 3;
 
     // preallocate arrays for scale degree, type and durations
@@ -161,34 +202,35 @@ int createRandomInput(char* filename)
 }
 
 /**
-*   Given a part, this function returns a pointer to an array of length seven with acceptable scale degrees.
+*   Figure out the n best harmony patterns given a melody
 **/
-int* determineHarmonicScaleDegrees(Part* part, int key)
+int determineHarmonies(Part* part_head, Rhythm* rhythm_head, int key, int beats, Harmony* harmonies[], int scores[], int n)
 {
-    if (part == NULL || key < -7 || key > 7)
+    // error checking
+    if (part_head == NULL || rhythm_head == NULL || n < 1)
     {
-        printf("Error determining scale degrees - bad part or key\n");
-        return NULL;
+        printf("Error determining harmony: no part or no rhythm\n");
+        return -1;
+    }
+
+    // harmonize the timelines of the lists
+    Timeline* part = timelineOfPart(part_head, NULL);
+    Timeline* rhythm = timelineOfRhythm(rhythm_head, NULL);
+    ChordTimeline* chords[n];
+    int found = -1;
+    if (part != NULL && rhythm != NULL)
+    {
+        found = determineHarmoniesTimeline(part, rhythm, key, beats, chords, scores, n);
+    }
+    for (int i = 0; i < found; i++)
+    {
+        harmonies[i] = harmonyOfChordTimeline(chords[i]);
+        chordTimelineFree(chords[i]);
     }
-    
-    // key runs from -7 to 7. add seven to make this index an array.
-    //                   0  1  2   3  4  5  6  7  8  9   10 11 12 13 14
-    //                   Cb Gb Db  Ab Eb Bb F  C  G  D   A  E  B  F# C#
-    int norm_to_C[15] = {1, 6, 11, 4, 9, 2, 7, 0, 5, 10, 3, 8, 1, 6, 11};
-    
-    // major scale degrees. non-chord tones are labeled 0;
-    int scale_degrees[12] = {1, 0, 2, 0, 3, 4, 0, 5, 0, 6, 0, 7};
-    
-    // scale degree of the note in the part
-    int scale_degree = scale_degrees[(part->note_num + norm_to_C[key] + 7) % 12];
-    
-    // an array of diatonic chords that contain the given scale degree
-    int* possible_degrees = malloc(sizeof(int) * 3);
-    possible_degrees[0] = scale_degree;
-    possible_degrees[1] = scale_degree == 0 ? 0 : ((scale_degree + 2) % 7) + 1;
-    possible_degrees[2] = scale_degree == 0 ? 0 : ((scale_degree + 4) % 7) + 1;
 
-    return possible_degrees;
+    timelineFree(part);
+    timelineFree(rhythm);
+    return found;
 }
 
 /**
@@ -203,205 +245,19 @@ Harmony* determineHarmony(Part* part_head, Rhythm* rhythm_head, int key, int bea
         return NULL;
     }
 
-    // randomize
-    srand(time(NULL) * global_seed++);
-
-    // keep track of the part, rhythm and harmony head pointers
-    Part* part_ptr = part_head;
-    Rhythm* rhythm_ptr = rhythm_head;
-    Harmony* harmony_head = NULL;
-    Harmony* harmony_ptr;
-
-    // determine length of part
-    int part_node_count = 0;
-    int part_divisions = 0;
-    while (part_ptr != NULL)
-    {
-        part_node_count++;
-        part_divisions += part_ptr->duration;
-        part_ptr = part_ptr->next;
-    }
-
-    // determine length of rhythm
-    int rhythm_node_count = 0;
-    int rhythm_divisions = 0;
-    while (rhythm_ptr != NULL)
-    {
-        rhythm_node_count++;
-        rhythm_divisions += rhythm_ptr->divisions;
-        rhythm_ptr = rhythm_ptr->next;
-    }
-
-    // verify the rhythm is of appropriate length
-    if (rhythm_divisions < part_divisions)
+    // harmonize the timelines of the lists
+    Timeline* part = timelineOfPart(part_head, NULL);
+    Timeline* rhythm = timelineOfRhythm(rhythm_head, NULL);
+    ChordTimeline* chords = NULL;
+    if (part != NULL && rhythm != NULL)
     {
-        printf("Error: Rhythm is not as long as the part\n");
-        return NULL;
+        chords = determineHarmonyTimeline(part, rhythm, key, beats);
     }
+    Harmony* harmony_head = (chords != NULL) ? harmonyOfChordTimeline(chords) : NULL;
 
-    // declare an array to hold all of the possible harmonies
-    int possible_harmonies[part_node_count][4];
-
-    // declare an array to keep track of the downbeat
-    int downbeat_factor[part_node_count];
-
-    // loop over the part, filling possible_harmonies with chords 
-    // that contain the note in the part, grouping by the grouping rhythm
-    part_ptr = part_head;
-    rhythm_ptr = rhythm_head;
-    int rhythm_node_num = 0;
-    int div_counter = 0;
-    int total_div_counter = 0;
-    for (int i = 0; i < part_node_count; i++)
-    {
-        // figure out if were on a downbeat and apply a weight to notes on a downbeat
-        if (beats == 4)
-        {
-            if (total_div_counter % (DIVISIONS * beats) == 0)
-                downbeat_factor[i] = 4;
-            else if (total_div_counter % (DIVISIONS * beats / 2) == 0)
-                downbeat_factor[i] = 3;
-            else
-                downbeat_factor[i] = 2;
-        }
-        else if (beats == 3)
-        {
-            if (total_div_counter % (DIVISIONS * beats) == 0)
-                downbeat_factor[i] = 2;
-            else
-                downbeat_factor[i] = 1;
-        }
-        else
-        {
-            printf("Error (determineHarmony): # beats not supported\n");
-            return NULL;
-        }
-
-        // populate the array with harmonies
-        int* temp = determineHarmonicScaleDegrees(part_ptr, key);
-        possible_harmonies[i][0] = temp[0];
-        possible_harmonies[i][1] = temp[1];
-        possible_harmonies[i][2] = temp[2];
-        free(temp);
-
-        // index which part of the harmony rhythm we're in (index starts at 0)
-        possible_harmonies[i][3] = rhythm_node_num;
-        div_counter += part_ptr->duration;
-        total_div_counter += part_ptr->duration;
-        if (div_counter >= rhythm_ptr->divisions)
-        {
-            div_counter = 0;
-            rhythm_node_num++;
-            rhythm_ptr = rhythm_ptr->next;
-        }
-
-        // next node
-        part_ptr = part_ptr->next;
-    }
-    
-    // declare an array that puts a harmony to each segment of a length defined by the Rhythm
-    // this will contain a number 1-7 for each node in rhythm, and will be synthesized into a harmony
-    int harmony[rhythm_node_count];
-
-    // populate some helper arrays with more information about possible chord structures
-    int bins[rhythm_node_count][7];
-    int bin_max[rhythm_node_count];
-    int node = 0;
-    for (int i = 0; i < rhythm_node_count; i++)
-    {
-        // initialize to 0
-        for (int j = 0; j < 7; j++)
-            bins[i][j] = 0;
-
-        // sum the possible chords for this measure
-        while (possible_harmonies[node][3] == i)
-        {
-            for (int j = 0; j < 3; j++)
-                if (possible_harmonies[node][j] != 0)
-                    bins[i][possible_harmonies[node][j] - 1] += downbeat_factor[node];
-                node++;
-
-            //don't inadvertently access out of bounds
-            if (node >= part_node_count)
-                break;
-        }
-
-        // find the bin maximum
-        bin_max[i] = 0;
-        for (int j = 0; j < 7; j++)
-            if (bins[i][j] > bin_max[i])
-                bin_max[i] = bins[i][j];
-
-    }
-
-    // loop over progressions, trying to find one that works best (how do we score these)
-    int good_progression = 1;
-    int iteration = 0;
-    int max_iterations = 0;
-    do
-    {
-        // loop over harmonic rhythm nodes, determining for each which harmony should be used
-        for (int i = 0; i < rhythm_node_count; i++)
-        {
-            // default to tonic
-            harmony[i] = 1;
-            if (i == 0 || i == rhythm_node_count - 1)
-                continue;
-            else
-            {
-                int rand_index;
-                do
-                {
-                    rand_index = rand() % 7;
-                    harmony[i] = rand_index + 1;
-                }
-                while (bins[i][rand_index] != bin_max[i]);
-            }
-        } 
-
-        // check to see if this harmony works
-        good_progression = 1;
-        for (int j = 1; j < rhythm_node_count; j++)
-        {
-            if (!allowedChordProgression(harmony[j - 1], harmony[j]))
-                good_progression = 0;
-        }
-        iteration++;
-    }
-    while (!good_progression && iteration <= max_iterations);
-
-    // diatonic types:
-    int type_of[7] = {0, 1, 1, 0, 0, 1, 2};
-
-    // loop over parts, writing a harmony
-    part_ptr = part_head;
-    rhythm_ptr = rhythm_head;
-    int current_node = 0;
-    while (rhythm_ptr != NULL)
-    {
-        // initialize the new harmony
-        if (harmony_head == NULL)
-        {
-            harmony_head = malloc(sizeof(Harmony));
-            harmony_ptr = harmony_head;
-        }
-
-        // fill with information
-        harmony_ptr->function = harmony[current_node++];
-        harmony_ptr->type_id = type_of[harmony_ptr->function - 1];
-        harmony_ptr->inversion = 0;
-        harmony_ptr->duration = rhythm_ptr->divisions;
-
-        // only allocate memory if necessary
-        if (rhythm_ptr->next != NULL)
-            harmony_ptr->next = malloc(sizeof(Harmony));
-        else 
-            harmony_ptr->next = NULL;
-
-        // go to the next node
-        rhythm_ptr = rhythm_ptr->next;
-        harmony_ptr = harmony_ptr->next;
-    }
+    timelineFree(part);
+    timelineFree(rhythm);
+    chordTimelineFree(chords);
 
     // return a reference to the first node of the Harmony
     return harmony_head;
@@ -412,66 +268,29 @@ Harmony* determineHarmony(Part* part_head, Rhythm* rhythm_head, int key, int bea
 **/
 int* determineMeter(Part* part)
 {
-    int meter[2] = {288, 384};
-    int max_score = 0;
-    int final_offset = 0;
-    int final_meter = 0;
-
-    for (int offset = 0; offset < 384; offset += DIVISIONS)
+    Timeline* timeline = timelineOfPart(part, NULL);
+    if (timeline == NULL)
     {
-        Part* ptr = part;
-        int meter_score[2] = {0,0};
-        int div_counter = 0;
-        
-        while (ptr != NULL)
-        {
-            for (int i = 0; i < 2; i++)
-            {
-                if (div_counter % meter[i] == offset)
-                    meter_score[i] += 2;
-                else if (i == 1 && div_counter % meter[i] == (meter[i] / 2) + offset)
-                    meter_score[i]++;
-            }
-            div_counter += ptr->duration;
-            ptr = ptr->next;
-        }
-        
-        for (int i = 0; i < 2; i++)
-        {
-            if (max_score < meter_score[i])
-            {
-                max_score = meter_score[i];
-                final_offset = offset;
-                final_meter = (i == 0) ? 3 : 4;
-            }
-        }
-    }
-    
-    if (final_meter == 0)
         return NULL;
+    }
+    int* final_values = determineMeterTimeline(timeline);
+    timelineFree(timeline);
 
-    int* final_values = malloc(sizeof(int) * 2);
-    final_values[0] = final_meter;
-    final_values[1] = final_offset;
-    
     return final_values;
 }
 
 /**
 * Generates a random arpeggio pattern
 **/
-int generateArpeggioPattern(int pattern[], int length)
+int generateArpeggioPattern(int pattern[], int length, Rng* rng)
 {
     // pattern starting place
-    srand(time(NULL) * global_seed);
-    global_seed++;
-
-    int place = rand() % 4;
+    int place = rngBelow(rng, 4);
 
     // increment pattern up or down by one randomly
     for (int i = 0; i < length; i++)
     {
-        int r = rand() % 3;
+        int r = rngBelow(rng, 3);
         switch (r)
         {    
             case 0:
@@ -492,18 +311,15 @@ int generateArpeggioPattern(int pattern[], int length)
 /**
 * Generates a random rhythm with the number of notes specified and over the duration specified
 **/
-int generateRhythmPattern(int rhythm[], int num_notes, int duration)
+int generateRhythmPattern(int rhythm[], int num_notes, int duration, Rng* rng)
 {
     int num_divisions = DIVISIONS * duration;
     rhythm[0] = num_divisions;
-    
-    // seed
-    srand(time(NULL) * global_seed++);
 
     // keep dividing notes in half
     for (int i = 1; i < num_notes; i++)
     {
-        int r = rand() % i;
+        int r = rngBelow(rng, i);
         rhythm[r] /= 2;
         rhythm[i] = rhythm[r];
     }
@@ -514,127 +330,41 @@ int generateRhythmPattern(int rhythm[], int num_notes, int duration)
 /**
 *   Writes a counterpoint part given a harmony and a rhythm
 **/
-Part* getCounterpointPart(Harmony* harmony, Rhythm* rhythm, Part* other_parts[], int num_parts, int key, int staff)
+Part* getCounterpointPart(Harmony* harmony, Rhythm* rhythm, Part* other_parts[], int num_parts, int key, int staff, Rng* rng)
 {
-
-    // these are the acceptable ranges to make bass and tenor parts - key 25 to key 40
-    int upper_bound = 40;
-    int lower_bound = 25;
-    
-    // allocate memory for a head node of a part
-    Part* new_part_head = malloc(sizeof(Part));
-    
-    // randomize
-    srand(time(NULL) * global_seed++);
-    
-    // useful for keeping track of where we are if harmony and parts are timed differently
-    int harmony_divisions = 0;
-    int rhythm_divisions = 0;
-    int part_divisions[num_parts];
+    // convert everything to timelines
+    ChordTimeline* chords = chordTimelineOfHarmony(harmony, NULL);
+    Timeline* rhythm_timeline = timelineOfRhythm(rhythm, NULL);
+    Timeline* others[num_parts];
+    int converted = (chords != NULL && rhythm_timeline != NULL);
     for (int i = 0; i < num_parts; i++)
-        part_divisions[i] = 0;
-   
-    // key runs from -7 to 7. add 7 to make this index an array. ex) norm_from_C[key + 7]
-    //                     0   1  2  3  4  5   6  7  8  9  10 11 12  13 14
-    //                     Cb  Gb Db Ab Eb Bb  F  C  G  D  A  E  B   F# C#
-    int norm_from_C[15] = {11, 6, 1, 8, 3, 10, 5, 0, 7, 2, 9, 4, 11, 6, 1};
-
-    // start in the octave below middle C (C3 to C4)
-    int reference_note = 28 + norm_from_C[key + 7];
-
-    // some pointers to keep track of the place in the rhythms and melodies.
-    Rhythm* rhythm_ptr = rhythm;
-    Part* new_part_ptr = new_part_head;
-    Part* prev_part_ptr = new_part_head;
-    Harmony* harmony_ptr = harmony;
-    Part* other_part_ptr[num_parts];
-    for (int i = 0; i < num_parts; i++)
-        other_part_ptr[i] = other_parts[i];
-
-    // track the previous note
-    int previous_note = reference_note;
-
-    // loop over nodes in the rhythm
-    while (rhythm_ptr != NULL && harmony_ptr != NULL)
     {
-        // determine which notes are allowed
-        Range allowed_range = getRange(harmony_ptr->function, harmony_ptr->type_id, key);
-
-        // loop over the notes in the range and eliminate the ones that aren't in range
-        for (int i = 0; i < 88; i++)
-            if (i + 1 > upper_bound || i + 1 < lower_bound)
-                allowed_range.notes[i] = 0;
-        
-        // disallow notes that are used in other parts
-        for (int i = 0; i < num_parts; i++)
-            if (other_part_ptr[i] != NULL)
-                allowed_range.notes[other_part_ptr[i]->note_num - 1] = 0;
-
-        // pick a note that's allowed within the rules of counterpoint
-        new_part_ptr->note_num = previous_note;
-        for (int i = 1; i < 12; i++)
+        others[i] = timelineOfPart(other_parts[i], NULL);
+        if (others[i] == NULL)
         {
-            if (isInRange(allowed_range, previous_note + i) && isInRange(allowed_range, previous_note - i))
-            {
-                if (rand() % 2 == 0)
-                {
-                    new_part_ptr->note_num = previous_note + i;
-                    break;
-                }
-                else
-                {
-                    new_part_ptr->note_num = previous_note - i;
-                    break;
-                }
-            }
-            else if (isInRange(allowed_range, previous_note + i))
-            {
-                new_part_ptr->note_num = previous_note + i;
-                break;
-            }
-            else if (isInRange(allowed_range, previous_note - i))
-            {
-                new_part_ptr->note_num = previous_note - i;
-                break;
-            }
-        }
-        new_part_ptr->duration = rhythm_ptr->divisions;
-        new_part_ptr->staff = staff;
-        new_part_ptr->rest = 0;
-        new_part_ptr->next = malloc(sizeof(Part));
-
-        // remember the previous note
-        previous_note = new_part_ptr->note_num;
-
-        // update the current harmony
-        rhythm_divisions += rhythm_ptr->divisions;
-        if (harmony_divisions < rhythm_divisions)
-        {
-            harmony_divisions += harmony_ptr->duration;
-            harmony_ptr = harmony_ptr->next;
+            converted = 0;
         }
+    }
 
-        // update each of the parts
-        for (int i = 0; i < num_parts; i++)
+    // write the part, and turn it back into a list
+    Part* new_part_head = NULL;
+    if (converted)
+    {
+        Timeline* new_part = getCounterpointTimeline(chords, rhythm_timeline, others, num_parts, key, staff, rng);
+        if (new_part != NULL)
         {
-            if (part_divisions[i] < rhythm_divisions && other_part_ptr[i] != NULL)
-            {
-                part_divisions[i] += other_part_ptr[i]->duration;
-                other_part_ptr[i] = other_part_ptr[i]->next;
-            }
+            new_part_head = partOfTimeline(new_part);
         }
-
-        // next
-        rhythm_ptr = rhythm_ptr->next;
-        prev_part_ptr = new_part_ptr;
-        new_part_ptr = new_part_ptr->next;
+        timelineFree(new_part);
     }
-    
+
     // free heap memory!
-    if (new_part_ptr == new_part_head)
-        new_part_head = NULL;
-    free(prev_part_ptr->next);
-    prev_part_ptr->next = NULL;
+    chordTimelineFree(chords);
+    timelineFree(rhythm_timeline);
+    for (int i = 0; i < num_parts; i++)
+    {
+        timelineFree(others[i]);
+    }
 
     return new_part_head;
 }
@@ -649,46 +379,13 @@ Part* getCounterpointPart(Harmony* harmony, Rhythm* rhythm, Part* other_parts[],
 **/
 Note getNote(int key_number, int key_sig)
 {
-    Note this_note;
-    if (key_number < 1 || key_number > 88)
+    if (key_number < 1 || key_number > 88 || key_sig < -7 || key_sig > 7)
     {
         printf("Error: not an acceptable note\n");
-        this_note.octave = 0;
-        this_note.alter = 0;
-        this_note.step = 0;
-        this_note.accidental = 0;
+        Note this_note = {0, 0, 0, 0};
+        return this_note;
     }
-    else
-    {   
-        int accidentals[15][12] = { {0,2,0,0,2,0,2,0,0,2,0,2},
-                                    {0,2,0,0,2,0,2,0,0,0,0,2},
-                                    {0,2,0,2,0,0,2,0,2,0,0,2},
-                                    {0,2,0,2,0,0,2,0,2,0,-1,0},
-                                    {0,2,0,2,0,-1,0,0,2,0,-1,0},
-                                    {-1,0,0,2,0,-1,0,0,2,0,-1,0},
-                                    {-1,0,0,2,0,-1,0,-1,0,0,-1,0},
-                                    {1,0,1,0,0,1,0,1,0,0,1,0},
-                                    {1,0,1,0,0,1,0,1,0,2,0,0},
-                                    {1,0,1,0,2,0,0,1,0,2,0,0},
-                                    {0,0,1,0,2,0,0,1,0,2,0,2},
-                                    {0,0,1,0,2,0,2,0,0,2,0,2},
-                                    {0,2,0,0,2,0,2,0,0,2,0,2},
-                                    {0,2,0,0,2,0,2,0,2,0,0,2},
-                                    {0,2,0,2,0,0,2,0,2,0,0,2}};
-        
-        // These arrays hold values that correspond to white and black keys on a piano
-        int sharp_alters[12] = {0,1,0,1,0,0,1,0,1,0,1,0};
-        int flat_alters[12] = {0,-1,0,-1,0,0,-1,0,-1,0,-1,0};
-        int sharp_steps[12] = {0,0,1,1,2,3,3,4,4,5,5,6};
-        int flat_steps[12] =  {0,1,1,2,2,3,4,4,5,5,6,6};
-        this_note.octave = floor((key_number + 8) / 12);
-        this_note.alter = (key_sig >= 0) ? sharp_alters[(key_number + 8) % 12] : 
-                                           flat_alters[(key_number + 8) % 12];
-        this_note.step = (key_sig >= 0) ? sharp_steps[(key_number + 8) % 12] : 
-                                          flat_steps[(key_number + 8) % 12];
-        this_note.accidental = accidentals[7 + key_sig][key_number % 12];
-    }
-    return this_note;
+    return note_table[key_number - 1][key_sig + 7];
 }
 
 /**
@@ -696,24 +393,15 @@ Note getNote(int key_number, int key_sig)
 **/
 int getNotes(int notes[], int alters[], Section section, int key)
 {
-    // auxilliary information for calculations based on diatonic major scale
-    int sharps[12] = {0,0,1,1,2,3,3,4,4,5,5,6};
-    int flats[12]  = {0,1,1,2,2,3,4,4,5,5,6,6};
-    int sharp_alters[12] = {0,1,0,1,0,0,1,0,1,0,1,0};
-    int flat_alters[12]  = {0,-1,0,-1,0,0,-1,0,-1,0,-1,0};
-    int function_offsets[7] = {0,2,4,5,7,9,11};
-    
-    // calculations
+    // calculations, one chord tone at a time from the lowest bit up
     int n = 0;
-    for (int i = 0; i < 12; i++)
+    for (unsigned int tones = section.type.notes; tones != 0; tones &= tones - 1)
     {
-        if (section.type.notes[i] == 1)
-        {
-            int idx = (i + (7 * key + 12 * 5) + function_offsets[section.function - 1]) % 12;
-            notes[n]  = (key > 0) ? sharps[idx] : flats[idx];
-            alters[n] = (key > 0) ? sharp_alters[idx] : flat_alters[idx];
-            n++;
-        }
+        int i = __builtin_ctz(tones);
+        int idx = (i + (7 * key + 12 * 5) + function_offsets[section.function - 1]) % 12;
+        notes[n]  = (key > 0) ? sharp_steps[idx] : flat_steps[idx];
+        alters[n] = (key > 0) ? sharp_alters[idx] : flat_alters[idx];
+        n++;
     }
 
     return 0;
@@ -728,64 +416,13 @@ int getNotes(int notes[], int alters[], Section section, int key)
 **/
 Part* getPart(const char* filename, int key)
 {
-    // attempt to open the file 
-    FILE* fp = fopen(filename, "r");
-    if (fp == NULL)
+    Timeline* timeline = getPartTimeline(filename, NULL);
+    if (timeline == NULL)
     {
-        printf("ERROR: bad input file for melody\n");
         return NULL;
     }
-
-    // allocate a pointer to the first Part node
-    Part* head = malloc(sizeof(Part));
-    Part* ptr = head;
-    Part* prev;
-
-    // buffer stores a line of characters
-    char buffer[MAX_STRING];
-    int index = 0;
-    
-    // loop over characters in the file
-    for (int c = fgetc(fp); c != EOF; c = fgetc(fp))
-    {
-        if (c == '\n')
-        {
-            // terminate the string and reset the index
-            buffer[index] = '\0';
-            index = 0;
-
-            // initialize the current node with the integer in the file
-            ptr->duration = atoi(buffer);
-
-            // next node
-            ptr->next = malloc(sizeof(Part));
-            prev = ptr;
-            ptr = ptr->next;
-        }
-        else if (c == ',')
-        {
-            // if this is the first ptr
-            if (head == NULL)
-                head = ptr;
-
-            // terminate the string and convert it to an integer
-            buffer[index] = '\0';
-            index = 0;
-            ptr->note_num = atoi(buffer);
-            ptr->staff = 1;
-            ptr->rest = 0;
-        }
-        else
-        {
-            // collect chars
-            buffer[index] = (char) c;
-            index++;
-        }
-    }
-    
-    // free the extra allocation for the last pointer
-    free(prev->next);
-    prev->next = NULL;
+    Part* head = partOfTimeline(timeline);
+    timelineFree(timeline);
 
     // return a reference to the first note in the part
     return head;
@@ -796,17 +433,23 @@ Part* getPart(const char* filename, int key)
 **/
 Range getRange(int function, int type_id, int key)
 { 
-    // key runs from -7 to 7. add seven to the key to make this index an array.
-    //                   0  1  2   3  4  5  6  7  8  9   10 11 12 13 14
-    //                   Cb Gb Db  Ab Eb Bb F  C  G  D   A  E  B  F# C#
-    int norm_factor[15] = {10, 3, 8, 1, 6, 11, 4, 9, 2, 7, 0, 5, 10, 3, 8};
-    int diatonic_adjust[7] = {0, 10, 8, 7, 5, 3, 1};
-
     Range range;
+    range.type_id = type_id;
     Type type = getType(type_id);
 
-    for (int i = 0; i < 88; i++)
-        range.notes[i] = type.notes[(i + norm_factor[key + 7] + diatonic_adjust[function - 1]) % 12];
+    // the pitch classes of the chord, as bits from the lowest key up
+    uint64_t pattern = typeRotate(type, norm_factor[key + 7] + diatonic_adjust[function - 1]);
+
+    // repeat them up the keyboard. the upper word starts on key 65, four pitch classes in
+    uint64_t upper = ((pattern >> 4) | (pattern << 8)) & 0xFFF;
+    range.keys[0] = 0;
+    range.keys[1] = 0;
+    for (int octave = 0; octave < 64; octave += 12)
+    {
+        range.keys[0] |= pattern << octave;
+        range.keys[1] |= upper << octave;
+    }
+    range.keys[1] &= ((uint64_t) 1 << (88 - 64)) - 1;
     return range;
 }
 
@@ -815,48 +458,13 @@ Range getRange(int function, int type_id, int key)
 **/
 Rhythm* getRhythm(int divisions, int beats, int style)
 {
-    Rhythm* head = NULL;
-    Rhythm* ptr;
-
-    // error checking
-    if (beats < 2 || beats > 4)
+    Timeline* timeline = getRhythmTimeline(divisions, beats, style, NULL);
+    if (timeline == NULL)
     {
-        printf("Error: getRhythm: number of beats not supported\n");
         return NULL;
     }
-
-    int div_counter = 0;
-    while (div_counter < divisions)
-    {
-        if (head == NULL)
-        {
-            head = malloc(sizeof(Rhythm));
-            ptr = head;
-        }
-        else if (ptr->next == NULL)
-        {
-            ptr->next = malloc(sizeof(Rhythm));
-            ptr = ptr->next;
-        }
-
-        // depending on the harmonization style, output different rhythms
-        switch (style)
-        {
-            case 0:
-                ptr->divisions = DIVISIONS * beats;
-                break;
-            case 1:
-                ptr->divisions = DIVISIONS;
-                break;
-            case 2:
-                ptr->divisions = DIVISIONS * 2;
-                break;
-            default:
-                ptr->divisions = DIVISIONS * beats;
-        }
-        div_counter += ptr->divisions;
-        ptr->next = NULL;
-    }
+    Rhythm* head = rhythmOfTimeline(timeline);
+    timelineFree(timeline);
 
     return head;
 }
@@ -871,101 +479,32 @@ Rhythm* getRhythm(int divisions, int beats, int style)
 Type getType(int id)
 {
     Type type;
-    type.id = id;
-    for (int i = 0; i < 12; i++)
-        type.notes[i] = 0;
-    switch (id)
-    {
-        case 0:                 // major
-            type.notes[0] = 1;
-            type.notes[4] = 1;
-            type.notes[7] = 1;
-            return type;
-        case 1:                 // minor
-            type.notes[0] = 1;
-            type.notes[3] = 1;
-            type.notes[7] = 1;
-            return type;
-        case 2:                 // diminished
-            type.notes[0] = 1;
-            type.notes[3] = 1;
-            type.notes[6] = 1;
-            return type;
-        case 3:                 // augmented
-            type.notes[0] = 1;
-            type.notes[4] = 1;
-            type.notes[8] = 1;
-            return type;
-        case 4:                 // major 7th
-            type.notes[0] = 1;
-            type.notes[4] = 1;
-            type.notes[7] = 1;
-            type.notes[11] = 1;
-            return type;
-        case 5:                 // dom 7th
-            type.notes[0] = 1;
-            type.notes[4] = 1;
-            type.notes[7] = 1;
-            type.notes[10] = 1;
-            return type;
-        case 6:                 // min 7th
-            type.notes[0] = 1;
-            type.notes[3] = 1;
-            type.notes[7] = 1;
-            type.notes[10] = 1;
-            return type;
-        case 7:                 // half dim 7th
-            type.notes[0] = 1;
-            type.notes[3] = 1;
-            type.notes[6] = 1;
-            type.notes[10] = 1;
-            return type;
-        case 8:                 // dim 7th
-            type.notes[0] = 1;
-            type.notes[3] = 1;
-            type.notes[6] = 1;
-            type.notes[9] = 1;
-            return type;
-        case 9:                 // min maj 7th
-            type.notes[0] = 1;
-            type.notes[3] = 1;
-            type.notes[7] = 1;
-            type.notes[11] = 1;
-            return type;
-        case 10:                // flat major
-            type.notes[11] = 1;
-            type.notes[3] = 1;
-            type.notes[6] = 1;
-            return type;
-        case 11:                // flat minor
-            type.notes[11] = 1;
-            type.notes[2] = 1;
-            type.notes[6] = 1;
-            return type;
-        case 12:                // sharp major
-            type.notes[1] = 1;
-            type.notes[5] = 1;
-            type.notes[8] = 1;
-            return type;
-        case 13:                // sharp minor
-            type.notes[1] = 1;
-            type.notes[4] = 1;
-            type.notes[8] = 1;
-            return type;
-        default:
-            type.id = -1;
-            return type;
+    if (id < 0 || id > 13)
+    {
+        type.id = -1;
+        type.notes = 0;
+        return type;
     }
+    type.id = id;
+    type.notes = type_notes[id];
+    return type;
 }
 
 /**
-* Returns a struct with compostion attributes supplied by a user
+* Returns a composition with the attributes supplied by a user, NULL if memory runs out
 *   If the filename supplied is invalid, it prompts user for input from the command line
 **/
-Composition getUserInput(char* filename)
+Composition* getUserInput(char* filename)
 {
     // declarations
-    Composition composition;
+    Composition* composition = compositionAlloc(0);
+    if (composition == NULL)
+    {
+        printf("Error allocating memory.\n");
+        return NULL;
+    }
+    int length = 0;
+    Section section;
 
     // read from a file if it's provided, otherwise get attributes from the command line
     FILE* fp_in = fopen(filename, "r");
@@ -977,19 +516,25 @@ Composition getUserInput(char* filename)
     else
     {
         // key is the first line in the file
-        fscanf(fp_in, "%d", &composition.key);
+        fscanf(fp_in, "%d", &composition->key);
 
         // length is the second line in the file
-        fscanf(fp_in, "%d", &composition.length);
+        fscanf(fp_in, "%d", &length);
 
         // initializations
         int type_id = 0;
         
-        // scan in a line (ex: 1,0,4 = tonic, major, 4 beats)
-        for (int i = 0; i < composition.length; i++)
+        // scan in a line (ex: 1,0,4 = tonic, major, 4 beats), one at a time, until the file runs out
+        for (int i = 0; i < length && fscanf(fp_in, "%d,%d,%f", &section.function, &type_id, &section.duration) == 3; i++)
         {
-            fscanf(fp_in, "%d,%d,%f", &composition.section[i].function, &type_id, &composition.section[i].duration);
-            composition.section[i].type = getType(type_id);
+            section.type = getType(type_id);
+            if (compositionAppend(composition, section) != 0)
+            {
+                printf("Error allocating memory.\n");
+                fclose(fp_in);
+                compositionFree(composition);
+                return NULL;
+            }
         }
 
         // close the input file
@@ -1000,18 +545,18 @@ Composition getUserInput(char* filename)
 
     // ask for length of chord sequence
     printf("How many chord changes in your piece? ");
-    scanf("%d", &(composition.length)); 
+    scanf("%d", &length); 
     
     // ask user for sections in the sequence
-    for (int i = 0; i < composition.length; i++)
+    for (int i = 0; i < length; i++)
     {
         // get the classical chord function
         do
         {
             printf("Input Function #%d: ", i + 1);
-            scanf("%d", &(composition.section[i].function));
+            scanf("%d", &section.function);
         }
-        while (composition.section[i].function < 1 || composition.section[i].function > 7);
+        while (section.function < 1 || section.function > 7);
 
         // get the chord type i.e. major, minor, etc
         do
@@ -1019,38 +564,158 @@ Composition getUserInput(char* filename)
             int type_id;
             printf("Input Type #%d: ", i + 1);
             scanf("%d", &type_id);
-            composition.section[i].type = getType(type_id);
+            section.type = getType(type_id);
         }
-        while (composition.section[i].type.id == -1);
+        while (section.type.id == -1);
 
         // get the chord duration
         do
         {
             printf("Input duration #%d (unit: quarter note): ", i + 1);
-            scanf("%f", &(composition.section[i].duration));
+            scanf("%f", &section.duration);
+        }
+        while (section.duration < .125 || section.duration > 4);
+
+        if (compositionAppend(composition, section) != 0)
+        {
+            printf("Error allocating memory.\n");
+            compositionFree(composition);
+            return NULL;
         }
-        while (composition.section[i].duration < .125 || composition.section[i].duration > 4);
     }
 
     // ask user for key (uses circle of fifths: ex) f = -1, c = 0, g = 1)
     do
     {
         printf("What key is your piece in? ");
-        scanf("%d", &composition.key);
+        scanf("%d", &composition->key);
     }
-    while ( -7 > composition.key || composition.key > 7);
+    while ( -7 > composition->key || composition->key > 7);
 
     // return results
     return composition;
 }
 
-
+
+/**
+*   Returns 1 if the note is in range, 0 if not
+**/
+int isInRange(Range range, int note_num)
+{
+    if (note_num < 1 || note_num > 88)
+    {
+        return 0;
+    }
+    return (range.keys[(note_num - 1) / 64] >> ((note_num - 1) % 64)) & 1;
+}
+
+/**
+*   Returns the lowest key in the range above note_num, 0 if there is none
+**/
+int rangeAbove(Range range, int note_num)
+{
+    // key k is bit k - 1, so the keys above note_num start at bit note_num
+    if (note_num < 0)
+    {
+        note_num = 0;
+    }
+    if (note_num < 64)
+    {
+        uint64_t lower = range.keys[0] & (~(uint64_t) 0 << note_num);
+        if (lower != 0)
+        {
+            return __builtin_ctzll(lower) + 1;
+        }
+    }
+    if (note_num < 128)
+    {
+        uint64_t upper = range.keys[1] & ((note_num <= 64) ? ~(uint64_t) 0 : ~(uint64_t) 0 << (note_num - 64));
+        if (upper != 0)
+        {
+            return __builtin_ctzll(upper) + 65;
+        }
+    }
+    return 0;
+}
+
+/**
+*   Returns the highest key in the range below note_num, 0 if there is none
+**/
+int rangeBelow(Range range, int note_num)
+{
+    // the keys below note_num are the lowest note_num - 1 bits
+    int count = note_num - 1;
+    if (count > 64)
+    {
+        uint64_t upper = range.keys[1] & ((count >= 128) ? ~(uint64_t) 0 : ((uint64_t) 1 << (count - 64)) - 1);
+        if (upper != 0)
+        {
+            return 64 - __builtin_clzll(upper) + 64;
+        }
+    }
+    if (count > 0)
+    {
+        uint64_t lower = range.keys[0] & ((count >= 64) ? ~(uint64_t) 0 : ((uint64_t) 1 << count) - 1);
+        if (lower != 0)
+        {
+            return 64 - __builtin_clzll(lower);
+        }
+    }
+    return 0;
+}
+
+/**
+*   Returns the keys that are in both ranges
+**/
+Range rangeIntersect(Range range, Range other)
+{
+    range.keys[0] &= other.keys[0];
+    range.keys[1] &= other.keys[1];
+    return range;
+}
+
+/**
+*   Returns a range of the keys from lowest to highest, inclusive
+**/
+Range rangeOfKeys(int lowest, int highest)
+{
+    Range range = {.keys = {0, 0}, .type_id = -1};
+    for (int word = 0; word < 2; word++)
+    {
+        // the bits of keys lowest to highest that fall in this word
+        int from = lowest - 1 - 64 * word;
+        int to = highest - 64 * word;
+        from = (from < 0) ? 0 : from;
+        to = (to > 64) ? 64 : to;
+        if (from < to)
+        {
+            uint64_t below_to = (to == 64) ? ~(uint64_t) 0 : ((uint64_t) 1 << to) - 1;
+            range.keys[word] = below_to & (~(uint64_t) 0 << from);
+        }
+    }
+    return range;
+}
+
+/**
+*   Returns the range with the key added
+**/
+Range rangeWith(Range range, int note_num)
+{
+    if (note_num >= 1 && note_num <= 88)
+    {
+        range.keys[(note_num - 1) / 64] |= (uint64_t) 1 << ((note_num - 1) % 64);
+    }
+    return range;
+}
+
 /**
-*   Returns 1 if the note is in range, 0 if not
+*   Returns the keys of the range that aren't in removed
 **/
-int isInRange(Range range, int note_num)
+Range rangeWithout(Range range, Range removed)
 {
-    return range.notes[note_num - 1];
+    range.keys[0] &= ~removed.keys[0];
+    range.keys[1] &= ~removed.keys[1];
+    return range;
 }
 
 /**
@@ -1112,53 +777,58 @@ int rmRhythm(Rhythm* head)
 **/
 int transpose(Part* part, int old_key, int new_key, int shift_direction)
 {
-    //                                F C G     
-    int norm_key[15] = {11,6,1,8,3,10,5,0,7,2,9,4,11,6,1};
-
-    if (new_key == old_key)
+    Timeline* timeline = timelineOfPart(part, NULL);
+    if (timeline == NULL)
+    {
         return 0;
-    
-    int shift = norm_key[new_key + 7] - norm_key[old_key + 7];
-
-    // determine amount to shift by
-    if (shift_direction == 1 && shift < 0)
-        shift += 12;
-    else if (shift_direction == -1 && shift > 0)
-        shift -= 12;
-    else if (shift_direction != 1 & shift_direction != -1)
-        printf("Error: shift direction must be either 1 or -1\n");
+    }
+    int shift = transposeTimeline(timeline, old_key, new_key, shift_direction);
 
-    // pointer to the current node
+    // copy the new notes back into the part
     Part* ptr = part;
-
-    // loop over all of the parts
-    while (ptr != NULL)
+    for (int i = 0; i < timeline->length; i++)
     {
-        if (shift_direction == 1)
-            if (ptr->note_num + shift > 88)
-                ptr->note_num += shift - 12;
-            else
-                ptr->note_num += shift;
-        else
-            if (ptr->note_num + shift < 1)
-                ptr->note_num += 12 + shift;
-            else
-                ptr->note_num += shift;
+        ptr->note_num = timeline->note_num[i];
         ptr = ptr->next;
     }
+    timelineFree(timeline);
     
     return shift;
 }
 
+/**
+*   Returns 1 if the chord type has the note pitch_class semitones above its root, 0 if not
+**/
+int typeHas(Type type, int pitch_class)
+{
+    return (type.notes >> (pitch_class % 12)) & 1;
+}
+
+/**
+*   Returns the notes of the type as seen from shift semitones above its root:
+*   bit i is set if the chord has the note i + shift semitones above the root
+**/
+int typeRotate(Type type, int shift)
+{
+    shift %= 12;
+    return ((type.notes >> shift) | (type.notes << (12 - shift))) & 0xFFF;
+}
+
+/**
+*   Returns the number of notes in the chord type
+**/
+int typeSize(Type type)
+{
+    return __builtin_popcount(type.notes);
+}
+
 /**
 * Writes an arpeggio in the measure provided
 **/
-int writeArpeggio(xmlNodePtr measure, Section section, int key, float note_dur)
+int writeArpeggio(xmlNodePtr measure, Section section, int key, float note_dur, Rng* rng)
 {
     // determine number of notes in the chord
-    int num_notes = 0;
-    for (int i = 0; i < 12; i++)
-        num_notes += section.type.notes[i];
+    int num_notes = typeSize(section.type);
 
     // determine the note names and accidentals
     int note_idx[num_notes];
@@ -1174,7 +844,7 @@ int writeArpeggio(xmlNodePtr measure, Section section, int key, float note_dur)
     // generate a new pattern
     int num = section.duration / note_dur;
     int pattern[num];
-    generateArpeggioPattern(pattern, num);
+    generateArpeggioPattern(pattern, num, rng);
 
     // loop over notes in the measure
     for (int i = 0; i < num; i++)
@@ -1196,9 +866,7 @@ int writeArpeggio(xmlNodePtr measure, Section section, int key, float note_dur)
 int writeChord(xmlNodePtr measure, Section section, int key)
 {
     // determine number of notes in the chord
-    int num_notes = 0;
-    for (int i = 0; i < 12; i++)
-        num_notes += section.type.notes[i];
+    int num_notes = typeSize(section.type);
 
     // determine the note names and accidentals
     int note_idx[num_notes];
@@ -1222,7 +890,7 @@ int writeChord(xmlNodePtr measure, Section section, int key)
 /**
 *   Writes a harmony to a file
 **/
-int writeHarmony(const char* filename, Harmony* harmony_head, int key)
+int writeHarmony(const char* filename, Harmony* harmony_head, int key, Rng* rng)
 {
     // write header, doc, root, and dtd
     xmlDocPtr doc = xmlNewDoc(BAD_CAST "1.0");
@@ -1236,7 +904,7 @@ int writeHarmony(const char* filename, Harmony* harmony_head, int key)
         Section section = {.function = harmony_ptr->function, 
             .type = getType(harmony_ptr->type_id), 
             .duration = harmony_ptr->duration / (float) DIVISIONS};
-        last_measure = writeSection(part, last_measure, section, key);
+        last_measure = writeSection(part, last_measure, &section, key, rng);
         harmony_ptr = harmony_ptr->next;
     }
 
@@ -1304,7 +972,7 @@ int writeMeasureAttributes(xmlNodePtr measure, MeasureAttribute measure_attribut
     xmlNewChild(attributes, NULL, BAD_CAST "divisions", BAD_CAST divisions);
     
     // if this is the first measure, some extra information is needed to specify key, time signature
-    if (measure_attributes.num == 1)
+    if (measure_attributes.num == 1 || measure_attributes.opening)
     {
         // define key
         char key_s[MAX_STRING];
@@ -1327,7 +995,7 @@ int writeMeasureAttributes(xmlNodePtr measure, MeasureAttribute measure_attribut
     // define number of staves - default 2
     xmlNewChild(attributes, NULL, BAD_CAST "staves", BAD_CAST "2");
 
-    if (measure_attributes.num == 1)
+    if (measure_attributes.num == 1 || measure_attributes.opening)
     {
         // define clefs
         xmlNodePtr g_clef = xmlNewChild(attributes, NULL, BAD_CAST "clef", NULL);
@@ -1345,12 +1013,10 @@ int writeMeasureAttributes(xmlNodePtr measure, MeasureAttribute measure_attribut
 /**
 * Writes a melody in the measure provided
 **/
-int writeMelody(xmlNodePtr measure, Section section, int key, float num)
+int writeMelody(xmlNodePtr measure, Section section, int key, float num, Rng* rng)
 {
     // determine number of notes in the chord
-    int num_notes = 0;
-    for (int i = 0; i < 12; i++)
-        num_notes += section.type.notes[i];
+    int num_notes = typeSize(section.type);
 
     // determine the note names and accidentals
     int note_idx[num_notes];
@@ -1365,11 +1031,11 @@ int writeMelody(xmlNodePtr measure, Section section, int key, float num)
 
     // generate a new arpeggio pattern
     int pattern[(int) (num * section.duration)];
-    generateArpeggioPattern(pattern, (int) (num * section.duration));
+    generateArpeggioPattern(pattern, (int) (num * section.duration), rng);
 
     // generate a new rhythm pattern
     int rhythm[(int) (num * section.duration)];
-    generateRhythmPattern(rhythm, (int)(num * section.duration), section.duration);
+    generateRhythmPattern(rhythm, (int)(num * section.duration), section.duration, rng);
 
     // loop over notes in the measure
     for (int i = 0; i < (int)(num * section.duration); i++)
@@ -1387,7 +1053,7 @@ int writeMelody(xmlNodePtr measure, Section section, int key, float num)
 /**
 *   Writes the music according to the specifications of the user
 **/
-int writeMusic(const char* filename, Composition composition)
+int writeMusic(const char* filename, Composition* composition, Rng* rng)
 {
     // write header, doc, root, and dtd
     xmlDocPtr doc = xmlNewDoc(BAD_CAST "1.0");
@@ -1395,8 +1061,8 @@ int writeMusic(const char* filename, Composition composition)
     xmlNodePtr last_measure = NULL;
 
     // loop over sections, writing each as a certain type
-    for (int i = 0; i < composition.length; i++)
-        last_measure = writeSection(part, last_measure, composition.section[i], composition.key);
+    for (int i = 0; i < composition->length; i++)
+        last_measure = writeSection(part, last_measure, &composition->section[i], composition->key, rng);
 
     // save the file with format information
     xmlSaveFormatFileEnc(filename, doc, "UTF-8", 1);
@@ -1412,17 +1078,6 @@ int writeMusic(const char* filename, Composition composition)
 int writeNote(xmlNodePtr measure, Note note_pitch, int num_divs, int tie_type, 
                int beam_pos, int chord, int staff, int numeral, int type_id, int rest)
 {   
-    // constants
-    char* numerals[10][7] = {{"I", "II", "III", "IV", "V", "VI", "VII"},
-                            {"i", "ii", "iii", "iv", "v", "vi", "vii"},
-                            {"i°", "ii°", "iii°", "iv°", "v°", "vi°", "vii°"},
-                            {"I+", "II+", "III+", "IV+", "V+", "vi+", "vii+"},
-                            {"Imaj7", "IImaj7", "IIImaj7", "IVmaj7", "Vmaj7", "VImaj7", "VIImaj7"},
-                            {"I7", "II7", "III7", "IV7", "V7", "VI7", "VII7"},
-                            {"i7", "ii7", "iii7", "iv7", "v7", "vi7", "vii7"},
-                            {"i°7", "ii°7", "iii°7", "iv°7", "v°7", "vi°7", "vii°7"},
-                            {"iø7", "iiø7", "iiiø7", "ivø7", "vø7", "viø7", "viiø7"},
-                            {"I∆7", "II∆7", "III∆7", "IV∆7", "V∆7", "VI∆7", "V∆7"}};
     // start a new note
     xmlNodePtr note = xmlNewChild(measure, NULL, BAD_CAST "note", NULL);
     
@@ -1456,11 +1111,16 @@ int writeNote(xmlNodePtr measure, Note note_pitch, int num_divs, int tie_type,
         xmlNewChild(pitch, NULL, BAD_CAST "octave", BAD_CAST octave_s);
         xmlNewChild(note, NULL, BAD_CAST "duration", BAD_CAST duration_s);
 
-        // define tie
-        if (tie_type > 0 || tie_type < 0)
+        // define tie: 1 starts one, -1 stops one, 2 stops one and starts the next
+        if (tie_type < 0 || tie_type == 2)
+        {
+            xmlNodePtr tie = xmlNewChild(note, NULL, BAD_CAST "tie", NULL);
+            xmlNewProp(tie, BAD_CAST "type", BAD_CAST "stop");
+        }
+        if (tie_type > 0)
         {
             xmlNodePtr tie = xmlNewChild(note, NULL, BAD_CAST "tie", NULL);
-            xmlNewProp(tie, BAD_CAST "type", BAD_CAST ((tie_type > 0) ? "start" : "stop"));
+            xmlNewProp(tie, BAD_CAST "type", BAD_CAST "start");
         }
 
         // define note appearance
@@ -1579,115 +1239,35 @@ int writeNote(xmlNodePtr measure, Note note_pitch, int num_divs, int tie_type,
 **/
 int writePart(const char* filename, Part* part[], int num_parts, int beats, int key, char* composer, char* title)
 {
-    // write header, doc, root, and dtd
-    xmlDocPtr doc = xmlNewDoc(BAD_CAST "1.0");
-    xmlNodePtr xml_part = writeHeader(doc, composer, title);
-    xmlNodePtr measure;
-
-    // initialize an array of pointers to parts, keep track of whether or not to display ties
-    Part* ptr[num_parts];
-    int tie_stat[num_parts];
+    // write the timelines of the parts
+    Timeline* parts[num_parts];
+    int result = 0;
     for (int i = 0; i < num_parts; i++)
     {
-        ptr[i] = part[i];
-        tie_stat[0] = 0;
-    }
-    
-    // process parts in parallel - this loops once per measure
-    int measure_counter = 1;
-    int finished = 0;
-    while (!finished)
-    {
-        // define measure attributes
-        measure = xmlNewChild(xml_part, NULL, BAD_CAST "measure", NULL);
-        MeasureAttribute attributes = {.key = key, .num = measure_counter++, .beats = beats, .beat_type = 4};
-        writeMeasureAttributes(measure, attributes);
-        
-        // count the number of divisions written per part 
-        int div_counter = 0;
-        int div_max = attributes.beats * DIVISIONS;
-
-        // loop over parts for this measure
-        for (int i = 0; i < num_parts; i++)
+        parts[i] = timelineOfPart(part[i], NULL);
+        if (parts[i] == NULL)
         {
-            // back by the amount written in the last part
-            if (div_counter != 0)
-            {
-                char backup_dur_s[MAX_STRING];
-                sprintf(backup_dur_s, "%d", div_counter);
-                xmlNodePtr backup = xmlNewChild(measure, NULL, BAD_CAST "backup", NULL);
-                xmlNewChild(backup, NULL, BAD_CAST "duration", BAD_CAST backup_dur_s);
-                div_counter = 0;
-            }
-
-            // if there's another note to write in the part, write it. split it if it's too long.
-            while (ptr[i] != NULL)
-            {
-                if (div_counter < div_max)
-                {
-                    div_counter += ptr[i]->duration;
-                    int extra_div = div_counter - div_max;
-                    
-                    // make sure the note is valid
-                    Note note = getNote(ptr[i]->note_num, attributes.key);
-                    if (note.step == 0 && note.octave == 0 && note.alter == 0)
-                    {
-                        printf("Error: Invalid note number\n");
-                        return -1;
-                    }
-
-                    if (extra_div <= 0)
-                    {
-                        writeNote(measure, note, ptr[i]->duration,
-                                (tie_stat[i] == 0)? 0 : -1, -1, 0, ptr[i]->staff, -1, -1, ptr[i]->rest);
-                        tie_stat[i] = 0;
-                        ptr[i] = ptr[i]->next;
-                    }
-                    // else note is too long
-                    else
-                    {
-                        // start a note that's tied to the next measure
-                        writeNote(measure, note, ptr[i]->duration - extra_div, 
-                                1, -1, 0, ptr[i]->staff, -1, -1, ptr[i]->rest);
-                        ptr[i]->duration = extra_div;
-                        tie_stat[i] = 1;
-                        div_counter -= extra_div;
-                    }
-                }
-                else if (div_counter == div_max)
-                {
-                    break; // breaks out of writing this part for this measure
-                }
-                else
-                {
-                    printf("ERROR: part was processed incorrectly\n");
-                    return -1;
-                }
-            }
-            
+            result = -1;
         }
-        
-        // signal for the loop to end if at the end of the parts
-        finished = 1;
-        for (int i = 0; i < num_parts; i++)
-            if (ptr[i] != NULL)
-                finished = 0;
     }
-    
-    // save the file with format information
-    xmlSaveFormatFileEnc(filename, doc, "UTF-8", 1);
-    xmlFreeDoc(doc);
-    xmlCleanupParser();
+    if (result == 0)
+    {
+        result = writeTimelines(filename, parts, num_parts, beats, key, composer, title);
+    }
 
-    // success
-    return 0;
+    // free memory
+    for (int i = 0; i < num_parts; i++)
+    {
+        timelineFree(parts[i]);
+    }
+    return result;
 }
 
 
 /*
 * Writes a section (which may not be exactly a measure long) in the part provided
 */
-xmlNodePtr writeSection(xmlNodePtr part, xmlNodePtr last_measure, Section section, int key)
+xmlNodePtr writeSection(xmlNodePtr part, xmlNodePtr last_measure, Section* section, int key, Rng* rng)
 {
     // keep track of measures
     static int measure_num = 0;
@@ -1707,7 +1287,7 @@ xmlNodePtr writeSection(xmlNodePtr part, xmlNodePtr last_measure, Section sectio
         writeMeasureAttributes(measure, attributes);
         
         // update the running count of the measure length
-        cur_measure = section.duration;
+        cur_measure = section->duration;
     }
     else
     {
@@ -1715,14 +1295,14 @@ xmlNodePtr writeSection(xmlNodePtr part, xmlNodePtr last_measure, Section sectio
         measure = last_measure;
 
         // add to old duration
-        cur_measure += section.duration;
+        cur_measure += section->duration;
     }
 
     // write chords
-    writeChord(measure, section, key);
+    writeChord(measure, *section, key);
 
     // write arpeggio chord voicings
-    writeArpeggio(measure, section, key, 1.0/2.0);
+    writeArpeggio(measure, *section, key, 1.0/2.0, rng);
 
     if (fmod(cur_measure, 4) != 0)
         return measure;
@@ -1739,7 +1319,9 @@ xmlNodePtr writeSection(xmlNodePtr part, xmlNodePtr last_measure, Section sectio
 ////////////////////
 ////////////////////
 
-Part* read(char* wavfile, int bpm, int divspermeasure)
+// the FIXED_POINT build gets its read() from fixed.c, and leaves out everything here that needs gsl
+#ifndef FIXED_POINT
+Part* read(char* wavfile, int bpm, int divspermeasure, AnalysisSettings settings)
 {
     // open files
     wavFileInfo* info = malloc(sizeof(wavFileInfo));
@@ -1773,10 +1355,11 @@ Part* read(char* wavfile, int bpm, int divspermeasure)
         return NULL;
     }
     
-    FILE* out = fopen("visual.txt", "w");
-    if (out == NULL)
+    // set up the pitch engine for this sample rate, shared by all the threads
+    PitchEngine* engine = pitchEngineAlloc(settings.engine, info->sample_rate);
+    if (engine == NULL)
     {
-        printf("Error opening file.\n");
+        printf("Error setting up the pitch engine.\n");
         fclose(info->fp);
         free(info);
         return NULL;
@@ -1794,285 +1377,327 @@ Part* read(char* wavfile, int bpm, int divspermeasure)
     double avg[num_avg];
     findAvgs(info, avg, num_avg);
 
-    // find and store the derivative of the averages
-    double* differences = diff(avg, num_avg);
-    if (differences == NULL)
+    // store the spectral features of the whole recording, so it can be reanalyzed without the audio
+    if (settings.features != NULL)
     {
-        printf("Error allocating memory.\n");
+        if (storeFeatures(settings.features, wavfile, info, avg, num_avg, settings.num_threads) != 0)
+        {
+            printf("Error writing features to %s\n", settings.features);
+        }
+    }
+
+    // split the recording at every onset, skipping ahead the length of a 16th note after each
+    int skip = (info->sample_rate / (4 * bpm / 60)) / AVG_WINDOW - 1;
+    double threshold_factor = (settings.threshold_factor > 0) ? settings.threshold_factor : THRESHOLD_FACTOR;
+    int num_jobs = 0;
+    NoteJob* jobs = findNotes(avg, num_avg, threshold_factor, skip, &num_jobs);
+    if (jobs == NULL)
+    {
+        printf("Error: no notes found.\n");
         fclose(info->fp);
-        fclose(out);
+        pitchEngineFree(engine);
         free(info);
         return NULL;
     }
 
-    // find the maximum derivative and set threshold
-    double threshold = max(differences, num_avg) * THRESHOLD_FACTOR;
-    
+    // keep a record of each analysis if asked to
+    NoteDiagnostics* diagnostics = NULL;
+    if (settings.diagnostics != NULL)
+    {
+        diagnostics = calloc(num_jobs, sizeof(NoteDiagnostics));
+        if (diagnostics == NULL)
+        {
+            printf("Error allocating memory.\n");
+            fclose(info->fp);
+            pitchEngineFree(engine);
+            free(info);
+            free(jobs);
+            return NULL;
+        }
+        for (int j = 0; j < num_jobs; j++)
+        {
+            jobs[j].diagnostics = &diagnostics[j];
+        }
+    }
+
+    // the notes don't depend on each other, so analyze them on a pool of threads
+    int num_threads = (settings.num_threads > 0) ? settings.num_threads : numProcessors();
+    if (num_threads > num_jobs)
+    {
+        num_threads = num_jobs;
+    }
+    NoteQueue queue = {.wavfile = wavfile, .info = info, .engine = engine, .jobs = jobs, .num_jobs = num_jobs, .next_job = 0};
+    pthread_mutex_init(&queue.lock, NULL);
+    void* args[num_threads];
+    for (int i = 0; i < num_threads; i++)
+    {
+        args[i] = &queue;
+    }
+    runThreads(num_threads, analyzeNotes, args);
+    pthread_mutex_destroy(&queue.lock);
+
+    // diagnostics go out in the order of the notes. they are only a record, so failing to write them isn't fatal
+    if (diagnostics != NULL)
+    {
+        if (writeDiagnostics(settings.diagnostics, jobs, num_jobs) != 0)
+        {
+            printf("Error writing diagnostics to %s\n", settings.diagnostics);
+        }
+        free(diagnostics);
+    }
+
     // create a singly linked-list of notes
-    // initializations
-    Part* head = NULL;
-    Part* cursor = NULL;
+    Part* head = assembleNotes(jobs, num_jobs, bpm, info->sample_rate, divspermeasure, settings.arena);
+
+    // close the file
+    fclose(info->fp);
+    pitchEngineFree(engine);
+    free(info);
+    free(jobs);
+    
+    return head;
+}
+#endif
+
+/**
+*   Builds the Part of a recording from its analyzed notes, in order. Noise is
+*   dropped, a note that rounds to no duration is overwritten by the next one,
+*   and the last note is cut at the end of a measure.
+*   The nodes come from the arena, or from malloc if that is NULL.
+*   Returns NULL if a note failed to analyze or memory runs out.
+**/
+Part* assembleNotes(NoteJob jobs[], int num_jobs, int bpm, int sample_rate, int divspermeasure, Arena* arena)
+{
+    Part* head = arenaMalloc(arena, sizeof(Part));
+    if (head == NULL)
+    {
+        printf("Error allocating memory.\n");
+        return NULL;
+    }
+    head->note_num = 0;
+    head->duration = 0;
+    head->staff = 1;
+    head->rest = 0;
+    head->next = NULL;
+
+    Part* cursor = head;
     Part* new_part = NULL;
     int duration_total = 0;
-    int counter = 0;
-    int start = 0;
-    int current_size = 0;
-    int note_length = 0;
-    double* data_left = NULL;
-    double* data_right = NULL;
-
-    // check each derivative to see if greater than threshold
-    for (int i = 0; i < num_avg - 1; i++)
+    for (int j = 0; j < num_jobs; j++)
     {
-        // if greater, add a part to the linked list
-        if (abs(differences[i]) >= threshold)
+        cursor->note_num = jobs[j].key_number;
+        if (cursor->note_num == -1)
         {
-            // first one?
-            if (head == NULL)
+            printf("Error analyzing data array\n");
+            if (arena == NULL)
             {
-                head = malloc(sizeof(Part));
-                if (head == NULL)
-                {
-                    printf("Error allocating memory.\n");
-                    fclose(info->fp);
-                    fclose(out);
-                    free(info);
-                    free(differences);
-                    return NULL;
-                }
-                
-                // initialize the head
-                head->note_num = 0;
-                head->duration = 0;
-                head->staff = 1;
-                head->rest = 0;
-                head->next = NULL;
-
-                // search return to search for next note
-                counter++;
-                start = i * AVG_WINDOW;
-                
-                // skip ahead the length of a 16th note
-                i += (info->sample_rate / (4 * bpm / 60)) / AVG_WINDOW - 1;
-                cursor = head;
+                rmPart(head);
             }
-            else
+            return NULL;
+        }
+
+        // ensure that the segment is not noise, then begin to fill part
+        if (cursor->note_num == 0)
+        {
+            continue;
+        }
+
+        // determine the duration and convert to an agreed upon standard (96 is a quarter note)
+        cursor->duration = round(((float)(bpm * (jobs[j].length)) / (sample_rate * 60)) * 4.0) * NOTESCALEFACTOR;
+
+        // keep track of total length
+        duration_total += cursor->duration;
+
+        // the final note stays at the cursor, cut at the end of a measure
+        if (j == num_jobs - 1)
+        {
+            cursor->duration -= ((duration_total / NOTESCALEFACTOR) % divspermeasure) * NOTESCALEFACTOR;
+        }
+        else if (cursor->duration > 0)
+        {
+            // create a new node
+            new_part = arenaMalloc(arena, sizeof(Part));
+            if (new_part == NULL)
             {
-                // edit previous node
-                note_length = i * AVG_WINDOW - start;
-                
-                // reallocate memory to expand array if necessary
-                if (note_length > current_size)
-                {
-                    data_left = realloc(data_left, sizeof(double) * powerOfTwo(note_length));
-                    if (data_left == NULL)
-                    {
-                        printf("Error allocating memory for data array\n");
-                        fclose(info->fp);
-                        fclose(out);
-                        free(info);
-                        free(differences);
-                        free(data_left);
-                        if (info->num_channels == 2)
-                        {
-                            free(data_right);
-                        }
-                        rmPart(head);
-                        return NULL;
-                    }
-                    current_size = powerOfTwo(note_length);
-                    
-                    // reallocate for second channel, if necessary
-                    if (info->num_channels == 2)
-                    {
-                        data_right = realloc(data_right, sizeof(double) * powerOfTwo(note_length));
-                        if (data_right == NULL)
-                        {
-                            printf("Error allocating memory for data array\n");
-                            fclose(info->fp);
-                            fclose(out);
-                            free(info);
-                            free(differences);
-                            free(data_left);
-                            if (info->num_channels == 2)
-                            {
-                                free(data_right);
-                            }
-                            rmPart(head);
-                            return NULL;
-                        }
-                    }
-                }
-                
-                
-                // reset file position to the start of the note
-                fseek(info->fp, 36 + (start * info->num_channels * sizeof(int16_t)), SEEK_SET);
-                
-                // create data array based on note length and determine note
-                makeWindow(info, data_left, data_right, note_length);
-                cursor->note_num = analyzeData(data_left, out, info, current_size);
-                if (cursor->note_num == -1)
+                printf("Error allocating memory for part\n");
+                if (arena == NULL)
                 {
-                    printf("Error analyzing data array\n");
-                    fclose(info->fp);
-                    fclose(out);
-                    free(info);
-                    free(differences);
-                    free(data_left);
-                    if (info->num_channels == 2)
-                    {
-                        free(data_right);
-                    }
                     rmPart(head);
-                    return NULL;
-                }
-                
-                
-                // ensure that the segment is not noise, then begin to fill part 
-                if (cursor->note_num > 0)
-                {
-                    // determine the duration and convert to an agreed upon standard (96 is a quarter note)
-                    cursor->duration = round(((float)(bpm * (note_length)) / (info->sample_rate * 60)) * 4.0) * NOTESCALEFACTOR;
-                    
-                    // keep track of total length
-                    duration_total += cursor->duration;
-
-                    if (cursor->duration > 0)
-                    {
-                        // create a new node
-                        new_part = malloc(sizeof(Part));
-                        if (new_part == NULL)
-                        {
-                            printf("Error allocating memory for part\n");
-                            fclose(info->fp);
-                            fclose(out);
-                            free(info);
-                            free(differences);
-                            free(data_left);
-                            if (info->num_channels == 2)
-                            {
-                                free(data_right);
-                            }
-                            rmPart(head);
-                            return NULL;
-                        }
-                        
-                        cursor->next = new_part;
-
-
-                        // initialize the new node
-                        new_part->note_num = 0;
-                        new_part->duration = 0;
-                        new_part->staff = 1;
-                        new_part->rest = 0;
-                        new_part->next = NULL;
-
-                        // move the cursor
-                        counter++;
-                        start = i * AVG_WINDOW;
-                        i += (info->sample_rate / (4 * bpm / 60)) / AVG_WINDOW - 1;
-                        cursor = new_part;
-                    }
-                    else
-                    {
-                        // reset start, jump ahead
-                        start = i * AVG_WINDOW;
-                        i += (info->sample_rate / (4 * bpm / 60)) / AVG_WINDOW - 1;
-                    }
-                }
-                else
-                {
-                    // reset start, jump ahead
-                    start = i * AVG_WINDOW;
-                    i += (info->sample_rate / (4 * bpm / 60)) / AVG_WINDOW - 1;
                 }
+                return NULL;
             }
+
+            cursor->next = new_part;
+
+            // initialize the new node
+            new_part->note_num = 0;
+            new_part->duration = 0;
+            new_part->staff = 1;
+            new_part->rest = 0;
+            new_part->next = NULL;
+
+            // move the cursor
+            cursor = new_part;
         }
     }
+    return head;
+}
 
-    // assume final note ends at the end of the file
-    note_length = num_avg * AVG_WINDOW - start;
-    
-    // reallocate if necessary
-    if (note_length > current_size)
+/**
+*   Splits the recording into notes wherever the derivative of the averages reaches
+*   threshold_factor of its maximum, skipping the given number of averages after each onset.
+*   Nothing before the first onset is a note; the last note runs to the end of the file.
+*   Returns the notes in order, NULL if there are none.
+**/
+NoteJob* findNotes(double avg[], int num_avg, double threshold_factor, int skip, int* num_jobs)
+{
+    NoteJob* jobs = NULL;
+    int capacity = 0;
+    *num_jobs = 0;
+
+    // find and store the derivative of the averages
+    double* differences = diff(avg, num_avg);
+    if (differences == NULL)
     {
-        data_left = realloc(data_left, sizeof(double) * powerOfTwo(note_length));
-        if (data_left == NULL)
-        {
-            printf("Error allocating memory for data array\n");
-            fclose(info->fp);
-            fclose(out);
-            free(info);
-            free(differences);
-            free(data_left);
-            if (info->num_channels == 2)
-            {
-                free(data_right);
-            }
-            rmPart(head);
-            return NULL;
-        }
-        current_size = powerOfTwo(note_length);
-        if (info->num_channels == 2)
+        printf("Error allocating memory.\n");
+        return NULL;
+    }
+
+    // find the maximum derivative and set threshold
+    double threshold = max(differences, num_avg - 1) * threshold_factor;
+
+    // check each derivative to see if greater than threshold
+    for (int i = 0; i < num_avg - 1; i++)
+    {
+        if (abs(differences[i]) >= threshold)
         {
-            data_right = realloc(data_right, sizeof(double) * powerOfTwo(note_length));
-            if (data_right == NULL)
+            if (*num_jobs == capacity)
             {
-                printf("Error allocating memory for data array\n");
-                fclose(info->fp);
-                fclose(out);
-                free(info);
-                free(differences);
-                free(data_left);
-                if (info->num_channels == 2)
+                capacity = (capacity == 0) ? 64 : capacity * 2;
+                NoteJob* bigger = realloc(jobs, sizeof(NoteJob) * capacity);
+                if (bigger == NULL)
                 {
-                    free(data_right);
+                    printf("Error allocating memory for notes\n");
+                    free(differences);
+                    free(jobs);
+                    *num_jobs = 0;
+                    return NULL;
                 }
-                rmPart(head);
-                return NULL;
+                jobs = bigger;
             }
+            jobs[*num_jobs].start = i * AVG_WINDOW;
+            (*num_jobs)++;
+            i += skip;
         }
     }
-    
-    // analyze final note data
-    makeWindow(info, data_left, data_right, note_length);
-    cursor->note_num = analyzeData(data_left, out, info, current_size);
-    if (cursor->note_num == -1)
+    free(differences);
+
+    // each note lasts until the next one starts, the last until the end of the file.
+    // the buffer a note is analyzed in fits the longest note up to it, as when they were analyzed in turn
+    int size = 0;
+    for (int j = 0; j < *num_jobs; j++)
+    {
+        int end = (j + 1 < *num_jobs) ? jobs[j + 1].start : num_avg * AVG_WINDOW;
+        jobs[j].length = end - jobs[j].start;
+        if (jobs[j].length > size)
         {
-            printf("Error analyzing data array\n");
-            fclose(info->fp);
-            fclose(out);
-            free(info);
-            free(differences);
-            free(data_left);
-            if (info->num_channels == 2)
+            size = powerOfTwo(jobs[j].length);
+        }
+        jobs[j].size = size;
+        jobs[j].key_number = 0;
+        jobs[j].diagnostics = NULL;
+    }
+    return jobs;
+}
+
+#ifndef FIXED_POINT
+/**
+*   Thread body for read(): takes notes off the queue until there are none left.
+*   Each thread has its own handle on the file, its own buffer and its own fft plan.
+**/
+void* analyzeNotes(void* queue)
+{
+    NoteQueue* q = queue;
+    wavFileInfo info = *q->info;
+    info.fp = fopen(q->wavfile, "r");
+
+    FFTPlan plan = {0};
+    float* data = NULL;
+    int current_size = 0;
+
+    while (1)
+    {
+        pthread_mutex_lock(&q->lock);
+        int j = q->next_job++;
+        pthread_mutex_unlock(&q->lock);
+        if (j >= q->num_jobs)
+        {
+            break;
+        }
+        NoteJob* job = &q->jobs[j];
+        job->key_number = -1;
+        if (info.fp == NULL)
+        {
+            continue;
+        }
+
+        // grow the buffer if necessary. it starts out zeroed, and the engines that
+        // use the padding clear it again after every note
+        if (job->size > current_size)
+        {
+            free(data);
+            current_size = job->size;
+            data = calloc(current_size, sizeof(float));
+            if (data == NULL)
             {
-                free(data_right);
+                current_size = 0;
+                continue;
             }
-            rmPart(head);
-            return NULL;
         }
-    
-    // if note is valid, store it and its duration
-    if (cursor->note_num > 0)
+
+        // the left channel of the note, from its first sample
+        fseek(info.fp, 36 + (job->start * info.num_channels * sizeof(int16_t)), SEEK_SET);
+        makeWindow(&info, data, NULL, job->length);
+
+        job->key_number = analyzeNote(q->engine, &plan, data, job->diagnostics, &info, job->length, job->size);
+        if (job->diagnostics != NULL)
+        {
+            job->diagnostics->key_number = job->key_number;
+        }
+    }
+
+    if (info.fp != NULL)
     {
-        cursor->duration = round(((float)(bpm * (note_length)) / (info->sample_rate * 60)) * 4.0) * NOTESCALEFACTOR;
-        duration_total += cursor->duration;
-        
-        // cut total length at the end of a measure
-        cursor->duration -= ((duration_total / NOTESCALEFACTOR) % divspermeasure) * NOTESCALEFACTOR;
+        fclose(info.fp);
     }
+    fftPlanFree(&plan);
+    free(data);
+    return NULL;
+}
+#endif
 
-    // close the file
-    fclose(info->fp);
-    fclose(out);
-    free(info);
-    free(differences);
-    free(data_left);
-    if (info->num_channels == 2)
-        free(data_right);
-    
-    return head;
+/**
+*   Writes the diagnostics of each note to a binary file: DIAGNOSTICS_MAGIC, then one
+*   NoteDiagnostics per note in order, in this machine's byte order. See visual.c.
+**/
+int writeDiagnostics(const char* filename, NoteJob jobs[], int num_jobs)
+{
+    FILE* fp = fopen(filename, "wb");
+    if (fp == NULL)
+    {
+        return 1;
+    }
+
+    int error = (fwrite(DIAGNOSTICS_MAGIC, 1, 4, fp) != 4);
+    for (int j = 0; j < num_jobs && !error; j++)
+    {
+        error = (fwrite(jobs[j].diagnostics, sizeof(NoteDiagnostics), 1, fp) != 1);
+    }
+    if (fclose(fp) != 0)
+    {
+        error = 1;
+    }
+    return error;
 }
 
 int findAvgs(wavFileInfo* info, double avg[], int num_avg)
@@ -2081,14 +1706,13 @@ int findAvgs(wavFileInfo* info, double avg[], int num_avg)
     int16_t buffer;
     
     // initialize the avg array to zero.
-    int pos = 0;
     for (int i = 0; i < num_avg; i++)
     {
         avg[i] = 0;
     }
     
-    // loop through, filling the avg array until returning
-    while (1)
+    // loop through, filling the avg array until it is full or the file ends
+    for (int pos = 0; pos < num_avg; pos++)
     {
         // find the average of every AVG_WINDOW points
         for (int i = 0; i < AVG_WINDOW; i++)
@@ -2107,37 +1731,41 @@ int findAvgs(wavFileInfo* info, double avg[], int num_avg)
             }
         }
         avg[pos] /= AVG_WINDOW;
-        pos++;
     }
+    return 0;
 }
 
 
-int makeWindow(wavFileInfo* info, double* data_left, double* data_right, int note_length)
+int makeWindow(wavFileInfo* info, float* data_left, float* data_right, int note_length)
 {
     // create buffer
     int16_t buffer;
     
-    // read the data from .wav file into data arrays
+    // read the data from .wav file into data arrays. data_right may be NULL to skip that channel
     for (int i = 0; i < note_length; i++)
     {
         if (fread(&buffer, sizeof(int16_t), 1, info->fp) != 1)
         {
             return 1;
         }
-        data_left[i] = (double) buffer;
+        data_left[i] = (float) buffer;
         if (info->num_channels == 2)
         {
             if (fread(&buffer, sizeof(int16_t), 1, info->fp) != 1)
             {
                 return 1;
             }
-            data_right[i] = (double) buffer;
+            if (data_right != NULL)
+            {
+                data_right[i] = (float) buffer;
+            }
         }
     }
     return 0;
 }
 
-int analyzeData(double data[], FILE* out, wavFileInfo* info, int current_size)
+#ifndef FIXED_POINT
+int analyzeData(float data[], NoteDiagnostics* diagnostics, wavFileInfo* info, int current_size, FFTPlan* plan)
 {
     // declarations and initializations
     float frequency = 0.0;
@@ -2145,22 +1773,11 @@ int analyzeData(double data[], FILE* out, wavFileInfo* info, int current_size)
     int key_number = 0;
 
     // run gsl fft
-    gsl_fft_real_wavetable* wavetable = gsl_fft_real_wavetable_alloc(current_size);
-    if (wavetable == NULL)
-    {
-        return -1;
-    }
-    gsl_fft_real_workspace* workspace = gsl_fft_real_workspace_alloc(current_size);
-    if (wavetable == NULL)
+    if (fftPlanSize(plan, current_size) != 0)
     {
-        gsl_fft_real_wavetable_free(wavetable);
         return -1;
     }
-
-    gsl_fft_real_transform(data, 1, current_size, wavetable, workspace);
-
-    gsl_fft_real_wavetable_free(wavetable);
-    gsl_fft_real_workspace_free(workspace);
+    gsl_fft_real_float_transform(data, 1, current_size, plan->wavetable, plan->workspace);
 
     // find the largest frequency component for the left channel
     float max = 0;
@@ -2224,8 +1841,12 @@ int analyzeData(double data[], FILE* out, wavFileInfo* info, int current_size)
         // increment correct bin in histogram
         gsl_histogram_increment(h, (idx / 2.0 * base_freq));
         
-        // print out top thirty frequencies and amplitudes for analysis
-        fprintf(out, "%.0f:%.0f\n", (idx / 2.0 * base_freq), max);
+        // keep the top thirty frequencies and amplitudes for analysis
+        if (diagnostics != NULL)
+        {
+            diagnostics->frequency[j] = idx / 2.0 * base_freq;
+            diagnostics->amplitude[j] = max;
+        }
         
         // set highest to zero, then repeat to find next highest
         data[idx] = 0;
@@ -2236,33 +1857,14 @@ int analyzeData(double data[], FILE* out, wavFileInfo* info, int current_size)
     key_number = max_key_number + findClumps(h, max_key_number);
 
 
-    // plot histogram for analysis
-    fprintf(out, "\n-----------------------\n");
-    char* names[12] = {"    A",
-            "A#/Bb",
-            "    B",
-            "    C",
-            "C#/Db",
-            "    D",
-            "D#/Eb",
-            "    E",
-            "    F",
-            "F#/Gb",
-            "    G",
-            "G#/Ab"};
-    
-    for (int i = 0; i < 88; i++)
+    // keep the histogram for analysis
+    if (diagnostics != NULL)
     {
-        fprintf(out, "%s(%d):",  names[i % 12], (i + 1));
-        size_t n = (size_t) i;
-        double x = gsl_histogram_get(h, n);
-        for (int j = 0; j < x; j++)
+        for (int i = 0; i < 88; i++)
         {
-            fprintf(out, "#");
+            diagnostics->histogram[i] = gsl_histogram_get(h, i);
         }
-        fprintf(out, "\n");
     }
-    fprintf(out, "\n***********************\n\n");
     
     // free the histogram
     gsl_histogram_free(h);
@@ -2275,6 +1877,7 @@ int analyzeData(double data[], FILE* out, wavFileInfo* info, int current_size)
 
     return key_number;
 }
+#endif
 
 int openWavFile(wavFileInfo* info)
 {
@@ -2355,6 +1958,7 @@ int openWavFile(wavFileInfo* info)
     return 0;
 }
 
+#ifndef FIXED_POINT
 int findClumps(gsl_histogram* h, int max_key)
 {
     int check = 0;
@@ -2396,6 +2000,7 @@ int findClumps(gsl_histogram* h, int max_key)
     }
     return 0;
 }
+#endif
 
 double* diff(double data[], int n)
 {
@@ -7,12 +7,22 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 #include <libxml/tree.h>
 #include <libxml/parser.h>
 #include <libxml/xmlreader.h>
+#ifdef FIXED_POINT
+// the fixed-point build (see fixed.c) has no gsl, these only keep the float declarations valid
+typedef struct gsl_histogram gsl_histogram;
+typedef struct gsl_fft_real_wavetable_float gsl_fft_real_wavetable_float;
+typedef struct gsl_fft_real_workspace_float gsl_fft_real_workspace_float;
+#else
 #include <gsl/gsl_errno.h>
 #include <gsl/gsl_fft_real.h>
+#include <gsl/gsl_fft_real_float.h>
 #include <gsl/gsl_histogram.h>
+#endif
+#include "threads.h"
 
 #define DIVISIONS 96 // this is the length of a quarter-note
 #define MAX_STRING 64
@@ -20,10 +30,56 @@
 #define NUMMAX 30
 #define AVG_WINDOW 300
 #define THRESHOLD_FACTOR .31
+#define DIAGNOSTICS_MAGIC "MXD1" // first four bytes of a diagnostics file
+#define FEATURES_MAGIC "MXF1" // first four bytes of a feature store
+#define FEATURE_FRAME 8192 // fft size of a feature frame
+#define FEATURE_HOP 2048 // samples between the starts of feature frames
+#define FEATURE_PEAKS 8 // spectral peaks kept per frame
+#define ARENA_CHUNK 65536 // bytes an arena asks malloc for at a time
+#define ARENA_ALIGN 16 // every block of an arena starts on a multiple of this
+#define MAX_THREADS 256 // most threads --threads may ask for, and a search runs
+#define SEARCH_CANDIDATES 1000 // harmonizations a search tries when it is given no budget
+#define COST_FIT 1 // per point of melody weight a chord falls short of the best chord there
+#define COST_PROGRESSION 50 // per step the progression rules don't allow
+#define COST_LEAP 2 // per semitone a voice moves beyond a whole step
+#define EDIT_CONTEXT 2 // nodes of the rhythm either side of an edit whose chords may change with it
+
+// strict c99 math.h leaves this out
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
 
+// pitch engines for read(), see pitch.c
+#define ENGINE_FFT 0
+#define ENGINE_YIN 1
+#define ENGINE_HPS 2
+#define ENGINE_GOERTZEL 3
+#define ENGINE_CQT 4
+#define ENGINE_SDFT 5
+#define NUM_ENGINES 6
+#define YIN_MIN_FREQ 50 // lowest pitch yin looks for, in Hz
+#define YIN_THRESHOLD .15
+#define YIN_FRAMES 8
+#define HPS_HARMONICS 5
+#define HPS_RESOLUTION 1.0 // width of a downsampled hps bin, in Hz
+#define GOERTZEL_PER_KEY 3
+#define GOERTZEL_FILTERS (88 * GOERTZEL_PER_KEY)
+#define GOERTZEL_BLOCK 4096
+#define FIXED_COEFF_BITS 28 // fixed-point goertzel coefficients are Q28
+#define FIXED_INPUT_SHIFT 2 // and drop two bits of each sample, so the filter states stay within 34 bits
+#define FIXED_STATE_SHIFT 4 // bits dropped from the states before squaring them
+#define FIXED_ENERGY_SHIFT 8 // bits dropped from each block's energy before summing
+#define CQT_BINS_PER_KEY 1
+#define CQT_SPARSITY .0054 // kernel entries smaller than this, relative to the largest, are dropped
+#define SDFT_WINDOW 8192 // longest sliding window, in samples. must be a power of two
+#define SDFT_PERIODS 17 // periods of its key in each bin's window, about a semitone of resolution where SDFT_WINDOW doesn't cap it
+#define SDFT_DAMPING .99999 // per sample, so rounding errors die out instead of piling up
+#define SDFT_HOP 512 // samples between looks at the spectrum when analyzing a whole note
+
+// a chord type. bit i of notes is set if the chord has the note i semitones above its root
 typedef struct
 {
-    int notes[12];
+    uint16_t notes;
     int id;
 } Type;
 
@@ -34,11 +90,13 @@ typedef struct
     float duration;
 } Section;
 
+// a chord chart, as many sections as it needs
 typedef struct
 {
     int key;
     int length;
-    Section section[1000];
+    int capacity;       // sections there is room for
+    Section* section;
 } Composition;
 
 typedef struct
@@ -49,11 +107,12 @@ typedef struct
     int accidental;
 } Note;
 
+// a set of piano keys: key k is bit (k - 1) % 64 of keys[(k - 1) / 64]
 typedef struct
 {
-    int notes[88];
+    uint64_t keys[2];
     int type_id;
-} Range; 
+} Range;
 
 typedef struct
 {
@@ -61,6 +120,7 @@ typedef struct
     int num;
     int beats;
     int beat_type;
+    int opening;        // the first measure written: key, time and clefs even if it isn't number 1
 } MeasureAttribute;
 
 typedef struct part
@@ -87,6 +147,115 @@ typedef struct harmony
     struct harmony* next;
 } Harmony;
 
+// a block of memory that an arena hands out in pieces, the pieces follow this header
+typedef struct arena_chunk
+{
+    size_t size;        // bytes after the header
+    size_t used;        // bytes handed out
+    size_t last;        // where the latest piece starts, so it can grow in place
+    struct arena_chunk* next;
+} ArenaChunk;
+
+// memory for one run of the pipeline, all given back at once. one thread at a time
+typedef struct
+{
+    ArenaChunk* chunks; // newest first, pieces come from the first
+} Arena;
+
+// a random number generator of its own (see random.c), for one thread or one candidate
+typedef struct
+{
+    uint64_t state;
+} Rng;
+
+// a voice as parallel arrays, one entry per note, in order. a rhythm is a
+// timeline that only uses its durations and onsets
+typedef struct
+{
+    int length;         // notes in the timeline
+    int capacity;       // notes there is room for
+    int* note_num;
+    int* duration;      // in divisions
+    int* onset;         // divisions from the start of the timeline to the note
+    int* staff;
+    int* rest;
+    Arena* arena;       // where the arrays come from, NULL for malloc
+} Timeline;
+
+// a harmony as parallel arrays, one entry per chord, in order
+typedef struct
+{
+    int length;
+    int capacity;
+    int* function;
+    int* type_id;
+    int* inversion;
+    int* duration;      // in divisions
+    int* onset;         // divisions from the start of the harmony to the chord
+    Arena* arena;
+} ChordTimeline;
+
+// a place in a timeline or a harmony, for asking what sounds at later and later times
+typedef struct
+{
+    const int* onset;
+    const int* duration;
+    int length;
+    int index;          // the event found last, or length once they have all ended
+} TimelineCursor;
+
+// where each measure of a score starts, and the note each part is sounding there
+typedef struct
+{
+    int length;         // measures in the score
+    int num_parts;
+    int beats;          // quarter notes in a measure
+    int* start;         // divisions from the start of the score to each measure
+    int* first;         // first[m * num_parts + p]: index of the note part p sounds at the start of measure m, -1 after its end
+    int* tied;          // the same, 1 if that note began in an earlier measure and is tied into this one
+    Arena* arena;
+} MeasureIndex;
+
+// how long searchHarmonization() looks for a better harmonization
+typedef struct
+{
+    int candidates;     // harmonizations to try, 0 for no limit
+    double seconds;     // time to try them in, 0 for no limit
+    int num_threads;    // 0 for one per processor
+    uint64_t seed;      // candidate c draws from rngOf(seed + c)
+} SearchSettings;
+
+// the candidates one thread tries for searchHarmonization(): first, first + step ...
+// each gets an arena of its own, and the arena of the best so far is kept
+typedef struct
+{
+    Timeline* part;
+    Timeline* rhythm;
+    int (*bins)[7];
+    int key;
+    int num_parts;
+    SearchSettings settings;
+    double deadline;    // on searchClock(), 0 for none
+    int first;
+    int step;
+    int tried;
+    int best;           // the best candidate, -1 until there is one
+    int best_cost;
+    Arena* arena;
+    ChordTimeline* harmony;
+    Timeline* parts[4];
+    int error;
+} SearchWorker;
+
+// what reharmonizeTimeline() wrote again: nodes of the rhythm, and the measures they are in
+typedef struct
+{
+    int first_node;
+    int last_node;
+    int first_measure;  // from 1, as writeMeasures() takes them
+    int last_measure;
+} EditRange;
+
 typedef struct
 {
     FILE* fp;
@@ -101,21 +270,500 @@ typedef struct
     int subchunk2_size;
 } wavFileInfo;
 
+typedef struct
+{
+    int engine;
+    int num_threads; // 0 for one per processor
+    char* diagnostics; // file to record the analysis of each note in, NULL for none
+    char* features; // file to store the spectral features of the recording in, NULL for none
+    double threshold_factor; // onset threshold relative to the largest, 0 for THRESHOLD_FACTOR
+    Arena* arena; // where the notes come from, NULL for malloc
+} AnalysisSettings;
+
+// what the analysis of one note found, as recorded in the diagnostics file
+typedef struct
+{
+    int32_t key_number;
+    double frequency[NUMMAX]; // the strongest fft peaks, strongest first
+    float amplitude[NUMMAX];
+    uint8_t histogram[88]; // how many of those peaks fell near each key
+} NoteDiagnostics;
+
+// one segment of the recording between two onsets, analyzed on its own
+typedef struct
+{
+    int start;          // first sample
+    int length;         // in samples
+    int size;           // length of the analysis buffer, a power of two
+    int key_number;     // result of the analysis
+    NoteDiagnostics* diagnostics; // NULL unless diagnostics are on
+} NoteJob;
+
+// a real fft of one size and its scratch space, reused from note to note. one per thread
+typedef struct
+{
+    int size;
+    gsl_fft_real_wavetable_float* wavetable;
+    gsl_fft_real_workspace_float* workspace;
+    float* frame;
+} FFTPlan;
+
+// sparse constant-q spectral kernels: bin b uses entries start[b] to start[b + 1] - 1
+typedef struct
+{
+    int sample_rate;
+    int fft_size;
+    int num_bins;
+    int num_entries;
+    int* start;
+    int* index;
+    float* re;
+    float* im;
+} CQKernel;
+
+typedef struct
+{
+    int type;
+    int sample_rate;
+    CQKernel* kernel;
+} PitchEngine;
+
+// sliding dft with one bin per piano key, brought up to date sample by sample.
+// bin k is the damped sum over its window of x[n - j] * z^j, z = r e^(-iw)
+typedef struct
+{
+    int sample_rate;
+    int pos;                // where the next sample goes in ring
+    int filled;             // samples pushed so far, up to SDFT_WINDOW
+    float* ring;            // the last SDFT_WINDOW samples
+    int window[88];         // samples in each bin's window, 0 above the nyquist frequency
+    double z_re[88];
+    double z_im[88];
+    double zn_re[88];       // z^window, for the sample leaving the window
+    double zn_im[88];
+    double y_re[88];        // the bins
+    double y_im[88];
+    double scale[88];       // sum of the damping weights, to compare bins of different windows
+} SlidingDFT;
+
+// spectral features of FEATURE_FRAME samples of a recording, from its start
+typedef struct
+{
+    int32_t start;
+    float frequency[FEATURE_PEAKS]; // the strongest spectral peaks, strongest first
+    float magnitude[FEATURE_PEAKS];
+    float energy[88]; // spectral energy nearest each key
+} FeatureFrame;
+
+// everything reanalyze() needs to turn a recording into notes again: the averages
+// read() finds the onsets in, and a frame of features every FEATURE_HOP samples
+typedef struct
+{
+    int sample_rate;
+    int num_samples;
+    int num_avg;
+    double* avg;
+    int num_frames;
+    FeatureFrame* frames;
+} FeatureStore;
+
+// the frames one thread computes for storeFeatures()
+typedef struct
+{
+    char* wavfile;
+    wavFileInfo* info;
+    FeatureFrame* frames;
+    int first;
+    int count;
+    int num_samples;
+    int error;
+} FeatureChunk;
+
+// the notes of one recording, handed out to the analysis threads in order
+typedef struct
+{
+    char* wavfile;
+    wavFileInfo* info;
+    PitchEngine* engine;
+    NoteJob* jobs;
+    int num_jobs;
+    int next_job;
+    pthread_mutex_t lock;
+} NoteQueue;
 
-extern int global_seed;
 
 // Tyler's functions:
-Part* read(char* wavfile, int bpm, int divspermeasure);
+Part* read(char* wavfile, int bpm, int divspermeasure, AnalysisSettings settings);
 int findAvgs(wavFileInfo* info, double avg[], int num_avg);
 int findClumps(gsl_histogram* h, int max_key);
 int openWavFile(wavFileInfo* info);
-int makeWindow(wavFileInfo* info, double* data_left, double* data_right, int note_length);
-int analyzeData(double* data, FILE* out, wavFileInfo* info, int current_size);
+int makeWindow(wavFileInfo* info, float* data_left, float* data_right, int note_length);
+int analyzeData(float* data, NoteDiagnostics* diagnostics, wavFileInfo* info, int current_size, FFTPlan* plan);
+NoteJob* findNotes(double avg[], int num_avg, double threshold_factor, int skip, int* num_jobs);
+Part* assembleNotes(NoteJob jobs[], int num_jobs, int bpm, int sample_rate, int divspermeasure, Arena* arena);
+void* analyzeNotes(void* queue);
+int writeDiagnostics(const char* filename, NoteJob jobs[], int num_jobs);
 double* diff(double data[], int n);
 double max(double data[], int n);
 int powerOfTwo(int v);
 
 
+// Pitch engines
+
+/**
+*   Sets up an engine of the given type for audio at the given sample rate
+**/
+PitchEngine* pitchEngineAlloc(int type, int sample_rate);
+int pitchEngineFree(PitchEngine* engine);
+
+/**
+*   Readies a plan for ffts of n points. An all-zero FFTPlan is an empty plan.
+**/
+int fftPlanSize(FFTPlan* plan, int n);
+int fftPlanFree(FFTPlan* plan);
+
+/**
+*   Determines the key number of a note with the selected engine
+**/
+int analyzeNote(PitchEngine* engine, FFTPlan* plan, float data[], NoteDiagnostics* diagnostics, wavFileInfo* info, int note_length, int current_size);
+
+/**
+*   Returns the engine number for a name given on the command line, -1 if unknown
+**/
+int engineOf(const char* name);
+
+/**
+*   Returns the piano key closest to a frequency, 0 if it is off the keyboard
+**/
+int keyOf(double frequency);
+
+/**
+*   YIN estimate of the period of one frame, in samples. 0 if unvoiced.
+**/
+double yinPeriod(float frame[], int window, int max_lag, float d[]);
+
+/**
+*   Time-domain pitch engine: key number most of the YIN frames agree on
+**/
+int yinKey(float data[], int length, int sample_rate);
+
+/**
+*   Replaces n samples with their magnitude spectrum, bins 0 to n / 2
+**/
+int magnitudeSpectrum(float data[], int n, FFTPlan* plan);
+
+/**
+*   Harmonic product spectrum engine: key of the strongest product of the
+*   downsampled spectrum and its compressed copies
+**/
+int hpsKey(float data[], int current_size, int sample_rate, FFTPlan* plan);
+
+/**
+*   Fills energy[88] with the energy of the note at each piano key
+**/
+int goertzelEnergies(float data[], int length, int sample_rate, double energy[88]);
+
+/**
+*   Picks the key whose harmonics hold the most energy, 0 if there is none
+**/
+int keyOfEnergies(double energy[88]);
+
+/**
+*   Goertzel filter bank engine
+**/
+int goertzelKey(float data[], int length, int sample_rate);
+
+/**
+*   Builds the sparse constant-q kernels for a sample rate, once per run
+**/
+CQKernel* cqtKernelAlloc(int sample_rate);
+int cqtKernelFree(CQKernel* kernel);
+
+/**
+*   Fills energy[88] with the constant-q energy of the note at each piano key
+**/
+int cqtEnergies(CQKernel* kernel, FFTPlan* plan, float data[], int length, double energy[88]);
+
+/**
+*   Constant-q engine
+**/
+int cqtKey(CQKernel* kernel, FFTPlan* plan, float data[], int length);
+
+/**
+*   Sets up a sliding dft over the piano keys for a stream at the given sample rate
+**/
+SlidingDFT* slidingDFTAlloc(int sample_rate);
+int slidingDFTFree(SlidingDFT* sdft);
+
+/**
+*   Brings every bin up to date with count more samples of the stream
+**/
+int slidingDFTUpdate(SlidingDFT* sdft, float samples[], int count);
+
+/**
+*   Fills energy[88] with the energy at each key over the most recent window
+**/
+int slidingDFTEnergies(SlidingDFT* sdft, double energy[88]);
+
+/**
+*   Key number of the stream right now, 0 if there is nothing there
+**/
+int slidingDFTKey(SlidingDFT* sdft);
+
+/**
+*   Sliding dft engine: a whole note streamed through, the spectrum summed every SDFT_HOP samples
+**/
+int sdftKey(float data[], int length, int sample_rate);
+
+
+// Feature store
+
+/**
+*   Computes the features of a whole recording and writes them, with its averages, to a file
+**/
+int storeFeatures(const char* filename, char* wavfile, wavFileInfo* info, double avg[], int num_avg, int num_threads);
+
+/**
+*   Thread body for storeFeatures(): computes one FeatureChunk
+**/
+void* computeFeatures(void* chunk);
+
+/**
+*   Fills in the features of one frame. data holds FEATURE_FRAME samples and is overwritten.
+**/
+int frameFeatures(float data[], FFTPlan* plan, int sample_rate, FeatureFrame* frame);
+
+/**
+*   Reads a feature store back, NULL if the file isn't one
+**/
+FeatureStore* readFeatures(const char* filename);
+int freeFeatures(FeatureStore* store);
+
+/**
+*   Key number of a stretch of the recording, from the frames inside it
+**/
+int featureKey(FeatureStore* store, int start, int length, int engine);
+
+/**
+*   Like read(), but from a feature store instead of the audio: no wav file and no ffts
+**/
+Part* reanalyze(const char* filename, int bpm, int divspermeasure, AnalysisSettings settings);
+
+
+// Fixed-point analysis, for the FIXED_POINT build only
+
+/**
+*   Sums of the absolute value of each AVG_WINDOW samples of the left channel
+**/
+int findAvgsFixed(wavFileInfo* info, int32_t sums[], int num_avg);
+
+/**
+*   findNotes() on the sums, with the threshold in thousandths of the largest derivative
+**/
+NoteJob* findNotesFixed(int32_t sums[], int num_avg, int threshold_permille, int skip, int* num_jobs);
+
+/**
+*   Q28 coefficients of the goertzel filters, the same filters goertzelEnergies uses
+**/
+int goertzelCoefficientsFixed(int sample_rate, int64_t coeff[GOERTZEL_FILTERS]);
+
+/**
+*   Streams length samples from the file's position through the filters, block by block
+**/
+int goertzelEnergiesFixed(wavFileInfo* info, int64_t coeff[GOERTZEL_FILTERS], int length, int64_t energy[88]);
+
+/**
+*   keyOfEnergies() for integer energies
+**/
+int keyOfEnergiesFixed(int64_t energy[88]);
+
+
+// Arenas
+
+/**
+*   An empty arena, NULL if memory runs out
+**/
+Arena* arenaAlloc(void);
+
+/**
+*   Gives back everything the arena handed out, and the arena
+**/
+int arenaFree(Arena* arena);
+
+/**
+*   malloc(), realloc() and free() for the pieces of an arena. With a NULL arena they
+*   are exactly those. Otherwise arenaRealloc() needs the old size of the piece, and
+*   arenaRelease() does nothing: the piece is given back with the arena.
+**/
+void* arenaMalloc(Arena* arena, size_t size);
+void* arenaRealloc(Arena* arena, void* ptr, size_t old_size, size_t size);
+void arenaRelease(Arena* arena, void* ptr);
+
+
+// Timelines
+
+/**
+*   An empty timeline with room for capacity notes, NULL if memory runs out.
+*   Its memory comes from the arena, or from malloc if that is NULL.
+**/
+Timeline* timelineAlloc(int capacity, Arena* arena);
+int timelineFree(Timeline* timeline);
+
+/**
+*   Adds a note at the end, or before the note at index. Returns 0, or 1 if memory runs out
+**/
+int timelineAppend(Timeline* timeline, int note_num, int duration, int staff, int rest);
+int timelineInsert(Timeline* timeline, int index, int note_num, int duration, int staff, int rest);
+
+/**
+*   Length of the whole timeline in divisions
+**/
+int timelineDuration(Timeline* timeline);
+
+/**
+*   The same for harmonies
+**/
+ChordTimeline* chordTimelineAlloc(int capacity, Arena* arena);
+int chordTimelineFree(ChordTimeline* chords);
+int chordTimelineAppend(ChordTimeline* chords, int function, int type_id, int inversion, int duration);
+
+/**
+*   Which note or chord sounds at a division: its index, or -1 after the end. The
+*   IndexAt functions search the onsets, a cursor steps forward from its last answer
+*   and searches only to go back
+**/
+int timelineIndexAt(Timeline* timeline, int division);
+int chordTimelineIndexAt(ChordTimeline* chords, int division);
+TimelineCursor timelineCursor(Timeline* timeline);
+TimelineCursor chordTimelineCursor(ChordTimeline* chords);
+int cursorIndexAt(TimelineCursor* cursor, int division);
+
+/**
+*   The measures of a score of parts, found once so any of them can be written without
+*   the ones before. From the arena, or malloc if it is NULL
+**/
+MeasureIndex* measureIndexAlloc(Timeline* parts[], int num_parts, int beats, Arena* arena);
+int measureIndexFree(MeasureIndex* index);
+
+/**
+*   Conversions to and from the linked lists. The lists returned are new and come
+*   from malloc, and an empty timeline becomes NULL.
+**/
+Timeline* timelineOfPart(Part* part, Arena* arena);
+Part* partOfTimeline(Timeline* timeline);
+Timeline* timelineOfRhythm(Rhythm* rhythm, Arena* arena);
+Rhythm* rhythmOfTimeline(Timeline* timeline);
+ChordTimeline* chordTimelineOfHarmony(Harmony* harmony, Arena* arena);
+Harmony* harmonyOfChordTimeline(ChordTimeline* chords);
+
+/**
+*   The notes a voice of getCounterpointTimeline() may play for a chord of the harmony
+*   at a division, with a cursor on each of the other parts
+**/
+Range counterpointRange(ChordTimeline* harmony, int chord, Timeline* other_parts[], TimelineCursor part_cursor[], int num_parts, int division, int key);
+
+/**
+*   One note of getCounterpointTimeline(): where a voice moves from previous_note for a
+*   chord of the harmony at a division, with a cursor on each of the other parts
+**/
+int counterpointNote(ChordTimeline* harmony, int chord, Timeline* other_parts[], TimelineCursor part_cursor[], int num_parts, int division, int key, int previous_note, Rng* rng);
+
+/**
+*   The harmonizing functions below, on timelines. Each list version converts
+*   its arguments and calls the timeline version. What they return comes from
+*   the arena of their first argument.
+**/
+int addPickupTimeline(Timeline* part, int beats, int meter);
+Timeline* copyTimelineRhythm(Timeline* part);
+int determineHarmoniesTimeline(Timeline* part, Timeline* rhythm, int key, int beats, ChordTimeline* harmonies[], int scores[], int n);
+ChordTimeline* determineHarmonyTimeline(Timeline* part, Timeline* rhythm, int key, int beats);
+int* determineMeterTimeline(Timeline* part);
+Timeline* getCounterpointTimeline(ChordTimeline* harmony, Timeline* rhythm, Timeline* other_parts[], int num_parts, int key, int staff, Rng* rng);
+Timeline* getPartTimeline(const char* filename, Arena* arena);
+Timeline* getRhythmTimeline(int divisions, int beats, int style, Arena* arena);
+int harmonyWeights(Timeline* part, Timeline* rhythm, int key, int beats, int first, int count, int bins[][7]);
+int transposeTimeline(Timeline* part, int old_key, int new_key, int shift_direction);
+int writeMeasures(const char* filename, Timeline* parts[], MeasureIndex* index, int first, int last, int key, char* composer, char* title);
+int writeTimelines(const char* filename, Timeline* parts[], int num_parts, int beats, int key, char* composer, char* title);
+
+
+// Random numbers
+
+/**
+*   A generator started from seed, the next 32 bits from it, and a number from 0 to n - 1.
+*   Everything that chooses at random takes one of these, and the same seed gives the
+*   same music. Nothing uses rand()
+**/
+Rng rngOf(uint64_t seed);
+uint32_t rngNext(Rng* rng);
+int rngBelow(Rng* rng, int n);
+
+
+// Harmony search
+
+/**
+*   Draws harmonizations at random, a harmony and then its voices, on settings.num_threads
+*   threads, and keeps the one that costs least. parts[0] is the melody, and the harmony
+*   and the other parts come from its arena. Returns the cost, or -1 if something goes
+*   wrong. With a budget of candidates the answer is the same for any number of threads
+**/
+int searchHarmonization(Timeline* part, Timeline* rhythm, int key, int beats, int num_parts, SearchSettings settings, ChordTimeline** harmony, Timeline* parts[], int* tried);
+
+/**
+*   Thread body for searchHarmonization(): tries the candidates of one SearchWorker
+**/
+void* searchCandidates(void* worker);
+
+/**
+*   A harmony drawn at random, a tonic at each end and each chord allowed after the one
+*   before, chords the melody suggests more being likelier. From the arena
+**/
+ChordTimeline* sampleHarmony(Timeline* rhythm, int bins[][7], Rng* rng, Arena* arena);
+
+/**
+*   What a harmonization costs: chords that fit the melody less than the best there,
+*   steps the progression rules don't allow, and leaps in the voices below the melody
+**/
+int harmonizationCost(ChordTimeline* harmony, int bins[][7], Timeline* parts[], int num_parts);
+
+/**
+*   Seconds on a clock that only goes forward
+**/
+double searchClock(void);
+
+
+// Edits
+
+/**
+*   After notes first_note to last_note of the melody, parts[0], change pitch (or become
+*   rests, or notes), finds the chords around them again and the voices under those, in
+*   place. Durations must stay as they were. edit, if not NULL, gets the nodes and the
+*   measures that changed, for writeMeasures(). Returns 0, or 1 on error
+**/
+int reharmonizeTimeline(Timeline* parts[], int num_parts, ChordTimeline* harmony, Timeline* rhythm, int key, int beats, int first_note, int last_note, Rng* rng, EditRange* edit);
+
+
+// Lookup tables, see tables.c. index by key + 7 and by function - 1
+
+extern const int norm_to_C[15];
+extern const int norm_from_C[15];
+extern const int norm_factor[15];
+extern const int diatonic_adjust[7];
+extern const int function_offsets[7];
+extern const int diatonic_types[7];
+extern const uint8_t chord_candidates[15][12];
+extern const int allowed_progressions[7][7];
+extern const uint16_t type_notes[14];
+extern const int sharp_steps[12];
+extern const int flat_steps[12];
+extern const int sharp_alters[12];
+extern const int flat_alters[12];
+extern const int accidentals[15][12];
+extern const int harmonic_offsets[5];
+extern const char* const numerals[10][7];
+extern const Note note_table[88][15];
+
+
 // Phil's functions
 
 /**
@@ -124,7 +772,7 @@ int powerOfTwo(int v);
 Part* addPickup(Part* part, int beats, int meter);
 
 /**
-*   Follow these guidelines when choosing a chord
+*   Follow these guidelines when choosing a chord. Takes chords as function - 1
 **/
 int allowedChordProgression(int first, int second);
 
@@ -133,6 +781,14 @@ int allowedChordProgression(int first, int second);
 **/
 int alterOf(char* note, int key);
 
+/**
+*   An empty composition with room for capacity sections, from malloc. Sections are
+*   added at the end, and the room grows as they are. NULL, or 1, if memory runs out
+**/
+Composition* compositionAlloc(int capacity);
+int compositionAppend(Composition* composition, Section section);
+int compositionFree(Composition* composition);
+
 /**
 *   Return a Rhythm with the same rhythm as a part
 **/
@@ -144,16 +800,19 @@ Rhythm* copyPartRhythm(Part* melody);
 *       2) chord progression starts on 1 and ends on 1
 *       3) length is somewhere bewteen 5 and 40 sections
 **/
-int createRandomInput(char* filename);
+int createRandomInput(char* filename, Rng* rng);
 
 /**
-*   Returns a pointer to an array of scale degree chords that contain the note.
+*   Fills harmonies with the n best harmonies for the part, best first, and scores with
+*   their scores. Returns how many it found, or -1 if something went wrong
 **/
-int* determineHarmonicScaleDegrees(Part* part, int key);
+int determineHarmonies(Part* part_head, Rhythm* rhythm_head, int key, int beats, Harmony* harmonies[], int scores[], int n);
 
 /**
 *   Returns a pointer to the first node of a Harmony
 *   Rhythm must be longer than the Part (in divisions, but not necessarily nodes)
+*   The harmony is the allowed progression from tonic to tonic that fits the melody
+*   best, the same every time for the same melody
 **/
 Harmony* determineHarmony(Part* part_head, Rhythm* rhythm_head, int key, int beats);
 
@@ -165,17 +824,17 @@ int* determineMeter(Part* part);
 /**
 *   Generates a random arpeggio pattern
 **/
-int generateArpeggioPattern(int pattern[], int length);
+int generateArpeggioPattern(int pattern[], int length, Rng* rng);
 
 /**
 *   Generates a random rhythm with the number of notes specified and over the duration specified
 **/
-int generateRhythmPattern(int rhythm[], int num_notes, int duration);
+int generateRhythmPattern(int rhythm[], int num_notes, int duration, Rng* rng);
 
 /**
 *   Writes a counterpoint part given a harmony and some other parts
 **/
-Part* getCounterpointPart(Harmony* harmony, Rhythm* rhythm, Part* other_parts[], int num_parts, int key, int staff);
+Part* getCounterpointPart(Harmony* harmony, Rhythm* rhythm, Part* other_parts[], int num_parts, int key, int staff, Rng* rng);
 
 /**
 *   Given a key number, returns a note struct with the following values:
@@ -219,16 +878,30 @@ Rhythm* getRhythm(int divisions, int beats, int style);
 Type getType(int id);
 
 /**
-*   Returns a struct with compostion attributes supplied by a user
+*   Returns a composition with the attributes supplied by a user, free it with compositionFree()
 *     -If the filename supplied is invalid, it prompts user for input from the command line
 **/
-Composition getUserInput(char* filename);
+Composition* getUserInput(char* filename);
 
 /**
 *   Returns 1 if the note is in range, 0 if not
 **/
 int isInRange(Range range, int note_num);
 
+/**
+*   The nearest key in the range above or below the note, 0 if there is none
+**/
+int rangeAbove(Range range, int note_num);
+int rangeBelow(Range range, int note_num);
+
+/**
+*   Set operations on ranges
+**/
+Range rangeIntersect(Range range, Range other);
+Range rangeOfKeys(int lowest, int highest);
+Range rangeWith(Range range, int note_num);
+Range rangeWithout(Range range, Range removed);
+
 /**
 *   Cleanup functions - free these linked lists.
 **/
@@ -241,10 +914,17 @@ int rmPart(Part* head);
 **/
 int transpose(Part* part, int old_key, int new_key, int shift_direction);
 
+/**
+*   Chord types as pitch-class sets: does it have a note, the set rotated, how many notes
+**/
+int typeHas(Type type, int pitch_class);
+int typeRotate(Type type, int shift);
+int typeSize(Type type);
+
 /**
 *   Writes an arpeggio in the measure provided
 **/
-int writeArpeggio(xmlNodePtr measure, Section section, int key, float note_dur);
+int writeArpeggio(xmlNodePtr measure, Section section, int key, float note_dur, Rng* rng);
 
 /**
 *   Writes a chord (should be the first in the sequence - no backup tag
@@ -254,7 +934,7 @@ int writeChord(xmlNodePtr measure, Section section, int key);
 /**
 *   Writes a harmony to a file
 **/
-int writeHarmony(const char* filename, Harmony* harmony_head, int key);
+int writeHarmony(const char* filename, Harmony* harmony_head, int key, Rng* rng);
 
 /**
 *   Writes an xml header appropriate for a music xml file
@@ -269,15 +949,17 @@ int writeMeasureAttributes(xmlNodePtr measure, MeasureAttribute measure_attribut
 /**
 *   Writes a melody in the measure provided
 **/
-int writeMelody(xmlNodePtr measure, Section sect, int key, float num);
+int writeMelody(xmlNodePtr measure, Section sect, int key, float num, Rng* rng);
 
 /**
 *   Writes the music according to the specifications of the user
 **/
-int writeMusic(const char* filename, Composition composition);
+int writeMusic(const char* filename, Composition* composition, Rng* rng);
 
 /**
-*   Writes a single note according to specification within the measure supplied
+*   Writes a single note according to specification within the measure supplied.
+*   tie_type is 1 to start a tie, -1 to stop one, 2 for both (the middle of a note
+*   tied across several measures) and 0 for none
 **/
 int writeNote(xmlNodePtr measure, Note note, int num_divs, int tie_type,
         int beam_pos, int chord, int staff, int numeral, int type, int rest);
@@ -290,6 +972,6 @@ int writePart(const char* filename, Part* part[], int num_parts, int beat, int k
 /**
 *   Writes a section (which may not be exactly a measure long) in the part provided
 **/
-xmlNodePtr writeSection(xmlNodePtr part, xmlNodePtr last_measure, Section section, int key);
+xmlNodePtr writeSection(xmlNodePtr part, xmlNodePtr last_measure, Section* section, int key, Rng* rng);
 
 #endif
@@ -0,0 +1,754 @@
+/********************************************************************************
+ *
+ * Pitch Engines
+ *
+ *  © Phil Ngo, Tyler Clites 2012
+ *
+ * Alternatives to the fft peak search in analyzeData. Every engine takes the
+ * samples of a single note, in single precision like the rest of the audio
+ * path, and returns the same thing analyzeData does:
+ *      a piano key number 1-88, 0 for noise or silence, -1 on error.
+ * read() picks one of them per run through AnalysisSettings.engine and keeps
+ * whatever the engine precomputes for the file's sample rate in a PitchEngine.
+ *
+********************************************************************************/
+
+#include "musicxml.h"
+
+/**
+*   Returns the engine number for a name given on the command line, -1 if unknown
+**/
+int engineOf(const char* name)
+{
+    char* names[NUM_ENGINES] = {"fft", "yin", "hps", "goertzel", "cqt", "sdft"};
+
+    for (int i = 0; i < NUM_ENGINES; i++)
+        if (strcmp(name, names[i]) == 0)
+            return i;
+    return -1;
+}
+
+/**
+*   Returns the piano key closest to a frequency, 0 if it is off the keyboard
+**/
+int keyOf(double frequency)
+{
+    if (frequency <= 0)
+        return 0;
+
+    int key_number = round(12 * log2(frequency / 440) + 49);
+    if (key_number < 1 || key_number > 88)
+        return 0;
+    return key_number;
+}
+
+/**
+*   Sets up an engine of the given type for audio at the given sample rate.
+*   Returns NULL if the type is unknown or memory runs out.
+**/
+PitchEngine* pitchEngineAlloc(int type, int sample_rate)
+{
+    if (type < 0 || type >= NUM_ENGINES)
+    {
+        printf("Error: unknown pitch engine\n");
+        return NULL;
+    }
+
+    PitchEngine* engine = malloc(sizeof(PitchEngine));
+    if (engine == NULL)
+        return NULL;
+    engine->type = type;
+    engine->sample_rate = sample_rate;
+    engine->kernel = NULL;
+
+    // the constant-q kernels only depend on the sample rate, so build them once here
+    if (type == ENGINE_CQT)
+    {
+        engine->kernel = cqtKernelAlloc(sample_rate);
+        if (engine->kernel == NULL)
+        {
+            free(engine);
+            return NULL;
+        }
+    }
+    return engine;
+}
+
+/**
+*   Frees an engine and whatever it precomputed
+**/
+int pitchEngineFree(PitchEngine* engine)
+{
+    if (engine == NULL)
+        return 0;
+    cqtKernelFree(engine->kernel);
+    free(engine);
+    return 0;
+}
+
+/**
+*   Readies a plan for ffts of n points, replacing its tables only when n changes.
+*   Returns 0 on success, -1 on error (the plan is left empty).
+**/
+int fftPlanSize(FFTPlan* plan, int n)
+{
+    if (plan->size == n)
+        return 0;
+    fftPlanFree(plan);
+
+    plan->wavetable = gsl_fft_real_wavetable_float_alloc(n);
+    plan->workspace = gsl_fft_real_workspace_float_alloc(n);
+    plan->frame = malloc(sizeof(float) * n);
+    if (plan->wavetable == NULL || plan->workspace == NULL || plan->frame == NULL)
+    {
+        fftPlanFree(plan);
+        return -1;
+    }
+    plan->size = n;
+    return 0;
+}
+
+/**
+*   Frees what a plan holds and leaves it empty
+**/
+int fftPlanFree(FFTPlan* plan)
+{
+    if (plan->wavetable != NULL)
+        gsl_fft_real_wavetable_float_free(plan->wavetable);
+    if (plan->workspace != NULL)
+        gsl_fft_real_workspace_float_free(plan->workspace);
+    free(plan->frame);
+    plan->size = 0;
+    plan->wavetable = NULL;
+    plan->workspace = NULL;
+    plan->frame = NULL;
+    return 0;
+}
+
+/**
+*   Determines the key number of a note with the selected engine.
+*   data must hold current_size samples: the note itself followed by zeros.
+*   plan belongs to the calling thread, engine may be shared between threads.
+*   Only the fft engine fills in diagnostics, which may be NULL.
+**/
+int analyzeNote(PitchEngine* engine, FFTPlan* plan, float data[], NoteDiagnostics* diagnostics, wavFileInfo* info, int note_length, int current_size)
+{
+    switch (engine->type)
+    {
+        case ENGINE_FFT:
+            return analyzeData(data, diagnostics, info, current_size, plan);
+        case ENGINE_YIN:
+            return yinKey(data, note_length, info->sample_rate);
+        case ENGINE_HPS:
+            return hpsKey(data, current_size, info->sample_rate, plan);
+        case ENGINE_GOERTZEL:
+            return goertzelKey(data, note_length, info->sample_rate);
+        case ENGINE_CQT:
+            return cqtKey(engine->kernel, plan, data, note_length);
+        case ENGINE_SDFT:
+            return sdftKey(data, note_length, info->sample_rate);
+        default:
+            printf("Error: unknown pitch engine\n");
+            return -1;
+    }
+}
+
+/**
+*   YIN estimate of the period of one frame, in samples (see de Cheveigné and Kawahara, 2002)
+*   frame holds window + max_lag samples, d is scratch space for max_lag + 1 floats.
+*   Returns 0 if the frame is unvoiced.
+**/
+double yinPeriod(float frame[], int window, int max_lag, float d[])
+{
+    // difference function. the lag loop is innermost so each step is independent and vectorizes
+    for (int tau = 0; tau <= max_lag; tau++)
+        d[tau] = 0;
+    for (int j = 0; j < window; j++)
+    {
+        float x = frame[j];
+        float* shifted = &frame[j];
+        for (int tau = 1; tau <= max_lag; tau++)
+        {
+            float delta = x - shifted[tau];
+            d[tau] += delta * delta;
+        }
+    }
+
+    // cumulative mean normalized difference
+    double running_sum = 0;
+    d[0] = 1;
+    for (int tau = 1; tau <= max_lag; tau++)
+    {
+        running_sum += d[tau];
+        d[tau] = (running_sum > 0) ? d[tau] * tau / running_sum : 1;
+    }
+
+    // first dip below the threshold, followed down to its local minimum
+    int tau = 2;
+    while (tau < max_lag && d[tau] >= YIN_THRESHOLD)
+        tau++;
+    if (tau >= max_lag)
+        return 0;
+    while (tau + 1 < max_lag && d[tau + 1] < d[tau])
+        tau++;
+
+    // parabolic interpolation between neighbouring lags
+    float left = d[tau - 1];
+    float right = d[tau + 1];
+    float denominator = left - 2 * d[tau] + right;
+    if (denominator == 0)
+        return tau;
+    return tau + (left - right) / (2 * denominator);
+}
+
+/**
+*   Time-domain pitch engine. Runs YIN on up to YIN_FRAMES short frames spread
+*   over the note and returns the key number most of them agree on.
+**/
+int yinKey(float data[], int length, int sample_rate)
+{
+    int max_lag = sample_rate / YIN_MIN_FREQ;
+    int window = max_lag;
+    int frame_length = window + max_lag;
+    if (length < frame_length)
+        return 0;
+
+    float* d = malloc(sizeof(float) * (max_lag + 1));
+    if (d == NULL)
+        return -1;
+
+    // spread the frames evenly over the note, skipping the attack
+    int votes[89] = {0};
+    int first = (length - frame_length) / 8;
+    int span = length - frame_length - first;
+    int num_frames = (span / frame_length < YIN_FRAMES) ? span / frame_length + 1 : YIN_FRAMES;
+    for (int i = 0; i < num_frames; i++)
+    {
+        int start = first + ((num_frames > 1) ? (long) span * i / (num_frames - 1) : 0);
+        double period = yinPeriod(&data[start], window, max_lag, d);
+        if (period > 0)
+            votes[keyOf(sample_rate / period)]++;
+    }
+    free(d);
+
+    // frames that landed off the keyboard don't count
+    votes[0] = 0;
+
+    // most common voiced key, 0 if no frame was voiced
+    int key_number = 0;
+    for (int i = 1; i <= 88; i++)
+        if (votes[i] > votes[key_number])
+            key_number = i;
+    return key_number;
+}
+
+/**
+*   Replaces the n samples in data with their magnitude spectrum, bins 0 to n / 2.
+*   n must be a power of two. Returns 0 on success, -1 on error.
+**/
+int magnitudeSpectrum(float data[], int n, FFTPlan* plan)
+{
+    if (fftPlanSize(plan, n) != 0)
+        return -1;
+    gsl_fft_real_float_transform(data, 1, n, plan->wavetable, plan->workspace);
+
+    // unpack the halfcomplex output in place. bin k only reads slots 2k - 1 and 2k,
+    // which are never behind the slot it is written to
+    data[0] = fabsf(data[0]);
+    for (int k = 1; k < n / 2; k++)
+        data[k] = sqrtf(data[2 * k - 1] * data[2 * k - 1] + data[2 * k] * data[2 * k]);
+    data[n / 2] = fabsf(data[n - 1]);
+
+    return 0;
+}
+
+/**
+*   Harmonic product spectrum engine. Max-pools the magnitude spectrum down to
+*   bins of about HPS_RESOLUTION Hz, multiplies it by copies of itself compressed
+*   by 2 .. HPS_HARMONICS, and returns the key of the strongest product.
+*   Clears data, like analyzeData, so the buffer is ready for the next note.
+**/
+int hpsKey(float data[], int current_size, int sample_rate, FFTPlan* plan)
+{
+    if (magnitudeSpectrum(data, current_size, plan) != 0)
+        return -1;
+
+    // downsample in place: pooled bin j only reads bins at or after j
+    double bin_width = sample_rate / (double) current_size;
+    int pool = (bin_width < HPS_RESOLUTION) ? HPS_RESOLUTION / bin_width : 1;
+    int num_bins = (current_size / 2 + 1) / pool;
+    float peak = 0;
+    for (int j = 0; j < num_bins; j++)
+    {
+        float loudest = 0;
+        for (int k = j * pool; k < (j + 1) * pool; k++)
+            if (data[k] > loudest)
+                loudest = data[k];
+        data[j] = loudest;
+        if (loudest > peak)
+            peak = loudest;
+    }
+    bin_width *= pool;
+
+    // scale to a peak of one so the products can't overflow a float
+    if (peak > 0)
+        for (int j = 0; j < num_bins; j++)
+            data[j] /= peak;
+
+    // fundamentals between key 1 and key 88 whose top harmonic is still in the spectrum
+    int lowest = 27.5 / bin_width;
+    int highest = 4186.0 / bin_width + 1;
+    if (highest > (num_bins - 1) / HPS_HARMONICS)
+        highest = (num_bins - 1) / HPS_HARMONICS;
+
+    // one multiply pass per harmonic, accumulated past the end of the pooled spectrum
+    int count = highest - lowest + 1;
+    int key_number = 0;
+    if (count > 0 && num_bins + count <= current_size)
+    {
+        float* product = &data[num_bins];
+        for (int k = 0; k < count; k++)
+            product[k] = data[lowest + k];
+        for (int h = 2; h <= HPS_HARMONICS; h++)
+            for (int k = 0; k < count; k++)
+                product[k] *= data[h * (lowest + k)];
+
+        int idx = 0;
+        for (int k = 1; k < count; k++)
+            if (product[k] > product[idx])
+                idx = k;
+        if (product[idx] > 0)
+            key_number = keyOf((lowest + idx) * bin_width);
+    }
+
+    // clear data array in preparation for next note
+    for (int i = 0; i < current_size; i++)
+        data[i] = 0;
+
+    return key_number;
+}
+
+/**
+*   Fills energy[88] with the energy of the note at each piano key. Each key gets
+*   GOERTZEL_PER_KEY goertzel filters spread across its semitone, run over blocks
+*   of GOERTZEL_BLOCK samples. The filter states are stored side by side, so the
+*   inner loop runs across the filters and vectorizes, and memory stays constant.
+**/
+int goertzelEnergies(float data[], int length, int sample_rate, double energy[88])
+{
+    float coeff[GOERTZEL_FILTERS];
+    float s1[GOERTZEL_FILTERS];
+    float s2[GOERTZEL_FILTERS];
+
+    // the center filter of each key sits on the same frequency as the middle of its range[] bin
+    for (int i = 0; i < GOERTZEL_FILTERS; i++)
+    {
+        double offset = (i % GOERTZEL_PER_KEY) - (GOERTZEL_PER_KEY - 1) / 2.0;
+        double frequency = 440 * pow(2.0, (i / GOERTZEL_PER_KEY - 48 + offset / GOERTZEL_PER_KEY) / 12.0);
+        coeff[i] = 2 * cos(2 * M_PI * frequency / sample_rate);
+    }
+    for (int k = 0; k < 88; k++)
+        energy[k] = 0;
+
+    for (int start = 0; start < length; start += GOERTZEL_BLOCK)
+    {
+        int end = (start + GOERTZEL_BLOCK < length) ? start + GOERTZEL_BLOCK : length;
+        for (int i = 0; i < GOERTZEL_FILTERS; i++)
+        {
+            s1[i] = 0;
+            s2[i] = 0;
+        }
+
+        // s[n] = x[n] + coeff * s[n - 1] - s[n - 2], for every filter at once
+        for (int n = start; n < end; n++)
+        {
+            float x = data[n];
+            for (int i = 0; i < GOERTZEL_FILTERS; i++)
+            {
+                float s0 = x + coeff[i] * s1[i] - s2[i];
+                s2[i] = s1[i];
+                s1[i] = s0;
+            }
+        }
+
+        // the block energies are summed in double, they can span many orders of magnitude
+        for (int i = 0; i < GOERTZEL_FILTERS; i++)
+            energy[i / GOERTZEL_PER_KEY] += (double) s1[i] * s1[i] + (double) s2[i] * s2[i]
+                - (double) coeff[i] * s1[i] * s2[i];
+    }
+
+    return 0;
+}
+
+/**
+*   Picks a key from per-key energies: the key whose first five harmonics
+*   (0, 12, 19, 24 and 28 semitones up) hold the most energy together.
+*   Returns 0 if there is no energy at all.
+**/
+int keyOfEnergies(double energy[88])
+{
+    int key_number = 0;
+    double loudest = 0;
+
+    for (int k = 0; k < 88; k++)
+    {
+        double sum = 0;
+        for (int h = 0; h < 5 && k + harmonic_offsets[h] < 88; h++)
+            sum += energy[k + harmonic_offsets[h]];
+        if (sum > loudest)
+        {
+            loudest = sum;
+            key_number = k + 1;
+        }
+    }
+    return key_number;
+}
+
+/**
+*   Goertzel filter bank engine: O(88 * N) time and constant memory
+**/
+int goertzelKey(float data[], int length, int sample_rate)
+{
+    double energy[88];
+    if (goertzelEnergies(data, length, sample_rate, energy) != 0)
+        return -1;
+    return keyOfEnergies(energy);
+}
+
+/**
+*   Builds the sparse spectral kernels of a constant-q transform with
+*   CQT_BINS_PER_KEY bins per semitone from key 1 up (see Brown and Puckette, 1992).
+*   Each bin's temporal kernel is a hamming-windowed complex exponential Q periods
+*   long; its spectrum is stored conjugated, keeping only the entries within
+*   CQT_SPARSITY of the largest. The fft size is the smallest power of two that
+*   fits the longest (lowest) kernel. Kernels are built in double precision and
+*   stored in single precision, to match the audio they are applied to.
+**/
+CQKernel* cqtKernelAlloc(int sample_rate)
+{
+    double Q = 1 / (pow(2, 1.0 / (12 * CQT_BINS_PER_KEY)) - 1);
+    int fft_size = powerOfTwo(ceil(Q * sample_rate / 27.5));
+
+    CQKernel* kernel = calloc(1, sizeof(CQKernel));
+    double* real_part = malloc(sizeof(double) * fft_size);
+    double* imaginary_part = malloc(sizeof(double) * fft_size);
+    if (kernel == NULL || real_part == NULL || imaginary_part == NULL)
+    {
+        free(kernel);
+        free(real_part);
+        free(imaginary_part);
+        return NULL;
+    }
+    kernel->sample_rate = sample_rate;
+    kernel->fft_size = fft_size;
+    kernel->num_bins = 88 * CQT_BINS_PER_KEY;
+    gsl_fft_real_wavetable* wavetable = gsl_fft_real_wavetable_alloc(fft_size);
+    gsl_fft_real_workspace* workspace = gsl_fft_real_workspace_alloc(fft_size);
+    kernel->start = malloc(sizeof(int) * (kernel->num_bins + 1));
+    if (wavetable == NULL || workspace == NULL || kernel->start == NULL)
+    {
+        if (wavetable != NULL)
+            gsl_fft_real_wavetable_free(wavetable);
+        if (workspace != NULL)
+            gsl_fft_real_workspace_free(workspace);
+        free(real_part);
+        free(imaginary_part);
+        cqtKernelFree(kernel);
+        return NULL;
+    }
+
+    int capacity = 0;
+    kernel->start[0] = 0;
+    for (int b = 0; b < kernel->num_bins; b++)
+    {
+        // temporal kernel, centered in the fft frame
+        double frequency = 27.5 * pow(2, b / (12.0 * CQT_BINS_PER_KEY));
+        int length = ceil(Q * sample_rate / frequency);
+        if (length > fft_size)
+            length = fft_size;
+        int offset = (fft_size - length) / 2;
+        for (int n = 0; n < fft_size; n++)
+        {
+            real_part[n] = 0;
+            imaginary_part[n] = 0;
+        }
+        for (int n = 0; n < length; n++)
+        {
+            double window = (.54 - .46 * cos(2 * M_PI * n / (length - 1))) / length;
+            real_part[offset + n] = window * cos(2 * M_PI * Q * n / length);
+            imaginary_part[offset + n] = window * sin(2 * M_PI * Q * n / length);
+        }
+
+        // spectrum of the complex kernel from two real transforms: K = A + iB
+        gsl_fft_real_transform(real_part, 1, fft_size, wavetable, workspace);
+        gsl_fft_real_transform(imaginary_part, 1, fft_size, wavetable, workspace);
+
+        // largest entry, to set the sparsity threshold. only the positive frequencies matter
+        double largest = 0;
+        for (int k = 1; k < fft_size / 2; k++)
+        {
+            double re = real_part[2 * k - 1] - imaginary_part[2 * k];
+            double im = real_part[2 * k] + imaginary_part[2 * k - 1];
+            if (re * re + im * im > largest)
+                largest = re * re + im * im;
+        }
+
+        // keep the significant entries, conjugated and normalized
+        for (int k = 1; k < fft_size / 2; k++)
+        {
+            double re = real_part[2 * k - 1] - imaginary_part[2 * k];
+            double im = real_part[2 * k] + imaginary_part[2 * k - 1];
+            if (re * re + im * im < largest * CQT_SPARSITY * CQT_SPARSITY)
+                continue;
+
+            if (kernel->num_entries == capacity)
+            {
+                capacity = (capacity == 0) ? 1024 : capacity * 2;
+                int* index = realloc(kernel->index, sizeof(int) * capacity);
+                if (index != NULL)
+                    kernel->index = index;
+                float* re_entries = realloc(kernel->re, sizeof(float) * capacity);
+                if (re_entries != NULL)
+                    kernel->re = re_entries;
+                float* im_entries = realloc(kernel->im, sizeof(float) * capacity);
+                if (im_entries != NULL)
+                    kernel->im = im_entries;
+                if (index == NULL || re_entries == NULL || im_entries == NULL)
+                {
+                    gsl_fft_real_wavetable_free(wavetable);
+                    gsl_fft_real_workspace_free(workspace);
+                    free(real_part);
+                    free(imaginary_part);
+                    cqtKernelFree(kernel);
+                    return NULL;
+                }
+            }
+            kernel->index[kernel->num_entries] = k;
+            kernel->re[kernel->num_entries] = re / fft_size;
+            kernel->im[kernel->num_entries] = -im / fft_size;
+            kernel->num_entries++;
+        }
+        kernel->start[b + 1] = kernel->num_entries;
+    }
+
+    gsl_fft_real_wavetable_free(wavetable);
+    gsl_fft_real_workspace_free(workspace);
+    free(real_part);
+    free(imaginary_part);
+    return kernel;
+}
+
+/**
+*   Frees the kernels built by cqtKernelAlloc
+**/
+int cqtKernelFree(CQKernel* kernel)
+{
+    if (kernel == NULL)
+        return 0;
+    free(kernel->start);
+    free(kernel->index);
+    free(kernel->re);
+    free(kernel->im);
+    free(kernel);
+    return 0;
+}
+
+/**
+*   Fills energy[88] with the constant-q energy of the note at each piano key.
+*   The note is cut into frames of the kernel's fft size, so the transform never
+*   grows with the note; the last frame is zero padded on both sides.
+*   The frames are transformed in the plan's scratch space.
+**/
+int cqtEnergies(CQKernel* kernel, FFTPlan* plan, float data[], int length, double energy[88])
+{
+    int n = kernel->fft_size;
+    if (fftPlanSize(plan, n) != 0)
+        return -1;
+    float* frame = plan->frame;
+
+    for (int k = 0; k < 88; k++)
+        energy[k] = 0;
+
+    for (int start = 0; start < length; start += n)
+    {
+        // a partial frame goes in the middle, where the short high-key kernels are centered
+        int count = (start + n < length) ? n : length - start;
+        int offset = (n - count) / 2;
+        for (int i = 0; i < n; i++)
+            frame[i] = 0;
+        for (int i = 0; i < count; i++)
+            frame[offset + i] = data[start + i];
+        gsl_fft_real_float_transform(frame, 1, n, plan->wavetable, plan->workspace);
+
+        // each bin is the dot product of the frame's spectrum with its sparse kernel
+        for (int b = 0; b < kernel->num_bins; b++)
+        {
+            float re = 0;
+            float im = 0;
+            for (int j = kernel->start[b]; j < kernel->start[b + 1]; j++)
+            {
+                int k = kernel->index[j];
+                re += frame[2 * k - 1] * kernel->re[j] - frame[2 * k] * kernel->im[j];
+                im += frame[2 * k - 1] * kernel->im[j] + frame[2 * k] * kernel->re[j];
+            }
+            energy[b / CQT_BINS_PER_KEY] += (double) re * re + (double) im * im;
+        }
+    }
+
+    return 0;
+}
+
+/**
+*   Constant-q engine: low notes get as many bins as high ones without a giant fft
+**/
+int cqtKey(CQKernel* kernel, FFTPlan* plan, float data[], int length)
+{
+    double energy[88];
+    if (cqtEnergies(kernel, plan, data, length, energy) != 0)
+        return -1;
+    return keyOfEnergies(energy);
+}
+
+/**
+*   Sets up a sliding dft over the piano keys (see Jacobsen and Lyons, 2003).
+*   Each key gets one bin whose window is SDFT_PERIODS of its periods, up to
+*   SDFT_WINDOW samples, so a bin resolves about a semitone. Keys below about
+*   92 Hz at 44.1 kHz (17 periods longer than 8192 samples) get the capped
+*   window, and their bins are wider than a semitone.
+*   Returns NULL if memory runs out.
+**/
+SlidingDFT* slidingDFTAlloc(int sample_rate)
+{
+    SlidingDFT* sdft = malloc(sizeof(SlidingDFT));
+    float* ring = calloc(SDFT_WINDOW, sizeof(float));
+    if (sdft == NULL || ring == NULL)
+    {
+        free(sdft);
+        free(ring);
+        return NULL;
+    }
+    sdft->sample_rate = sample_rate;
+    sdft->pos = 0;
+    sdft->filled = 0;
+    sdft->ring = ring;
+
+    for (int k = 0; k < 88; k++)
+    {
+        double frequency = 440 * pow(2.0, (k - 48) / 12.0);
+        int window = ceil(SDFT_PERIODS * sample_rate / frequency);
+        if (window > SDFT_WINDOW)
+            window = SDFT_WINDOW;
+        if (frequency >= sample_rate / 2.0)
+            window = 0;
+
+        double w = 2 * M_PI * frequency / sample_rate;
+        double rn = pow(SDFT_DAMPING, window);
+        sdft->window[k] = window;
+        sdft->z_re[k] = SDFT_DAMPING * cos(w);
+        sdft->z_im[k] = -SDFT_DAMPING * sin(w);
+        sdft->zn_re[k] = rn * cos(w * window);
+        sdft->zn_im[k] = -rn * sin(w * window);
+        sdft->y_re[k] = 0;
+        sdft->y_im[k] = 0;
+        sdft->scale[k] = (1 - rn) / (1 - SDFT_DAMPING);
+    }
+    return sdft;
+}
+
+/**
+*   Frees a sliding dft
+**/
+int slidingDFTFree(SlidingDFT* sdft)
+{
+    if (sdft == NULL)
+        return 0;
+    free(sdft->ring);
+    free(sdft);
+    return 0;
+}
+
+/**
+*   Brings every bin up to date with count more samples of the stream, at a cost
+*   of one complex multiply-add per bin per sample: y = x[n] + z y - z^window x[n - window].
+*   The bins are kept in double, they are carried along for the whole stream.
+**/
+int slidingDFTUpdate(SlidingDFT* sdft, float samples[], int count)
+{
+    for (int n = 0; n < count; n++)
+    {
+        float x = samples[n];
+        for (int k = 0; k < 88; k++)
+        {
+            if (sdft->window[k] == 0)
+                continue;
+
+            // the sample leaving this bin's window, nothing until the window has filled
+            float old = 0;
+            if (sdft->filled >= sdft->window[k])
+                old = sdft->ring[(sdft->pos - sdft->window[k]) & (SDFT_WINDOW - 1)];
+
+            double re = x - sdft->zn_re[k] * old + sdft->z_re[k] * sdft->y_re[k] - sdft->z_im[k] * sdft->y_im[k];
+            double im = -sdft->zn_im[k] * old + sdft->z_re[k] * sdft->y_im[k] + sdft->z_im[k] * sdft->y_re[k];
+            sdft->y_re[k] = re;
+            sdft->y_im[k] = im;
+        }
+
+        sdft->ring[sdft->pos] = x;
+        sdft->pos = (sdft->pos + 1) & (SDFT_WINDOW - 1);
+        if (sdft->filled < SDFT_WINDOW)
+            sdft->filled++;
+    }
+    return 0;
+}
+
+/**
+*   Fills energy[88] with the energy at each key over the most recent window,
+*   scaled so that bins with windows of different lengths can be compared
+**/
+int slidingDFTEnergies(SlidingDFT* sdft, double energy[88])
+{
+    for (int k = 0; k < 88; k++)
+    {
+        if (sdft->window[k] == 0)
+            energy[k] = 0;
+        else
+            energy[k] = (sdft->y_re[k] * sdft->y_re[k] + sdft->y_im[k] * sdft->y_im[k])
+                / (sdft->scale[k] * sdft->scale[k]);
+    }
+    return 0;
+}
+
+/**
+*   Key number of the stream right now, 0 if there is nothing there
+**/
+int slidingDFTKey(SlidingDFT* sdft)
+{
+    double energy[88];
+    slidingDFTEnergies(sdft, energy);
+    return keyOfEnergies(energy);
+}
+
+/**
+*   Sliding dft engine: streams the note through a fresh sliding dft, summing the
+*   energies every SDFT_HOP samples, and picks the key of the sum
+**/
+int sdftKey(float data[], int length, int sample_rate)
+{
+    SlidingDFT* sdft = slidingDFTAlloc(sample_rate);
+    if (sdft == NULL)
+        return -1;
+
+    double total[88] = {0};
+    double energy[88];
+    for (int start = 0; start < length; start += SDFT_HOP)
+    {
+        int count = (start + SDFT_HOP < length) ? SDFT_HOP : length - start;
+        slidingDFTUpdate(sdft, &data[start], count);
+        slidingDFTEnergies(sdft, energy);
+        for (int k = 0; k < 88; k++)
+            total[k] += energy[k];
+    }
+
+    slidingDFTFree(sdft);
+    return keyOfEnergies(total);
+}
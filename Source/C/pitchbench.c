@@ -0,0 +1,104 @@
+/********************************************************************************
+ *
+ * Pitch engine benchmark
+ *
+ * Synthesizes sung-like notes with a known key number (a fundamental that is
+ * weaker than its second harmonic, plus a little vibrato) and times each pitch
+ * engine on them. Reports the exact hits, the octave errors and the time spent.
+ *
+ *  usage: pitchbench [note length in seconds]
+ *
+********************************************************************************/
+
+#include "musicxml.h"
+
+#define BENCH_RATE 44100
+#define BENCH_LOW_KEY 20    // E2
+#define BENCH_HIGH_KEY 64   // C6
+
+void synthesize(float data[], int length, int key_number, int sample_rate);
+
+int main(int argc, char* argv[])
+{
+    double seconds = (argc > 1) ? atof(argv[1]) : .5;
+    int length = seconds * BENCH_RATE;
+    if (length < 1)
+    {
+        printf("USAGE: pitchbench [note length in seconds]\n");
+        return 1;
+    }
+
+    // analyzeData wants a power of two buffer
+    int current_size = powerOfTwo(length);
+    float* data = calloc(current_size, sizeof(float));
+    if (data == NULL)
+    {
+        printf("Error setting up the benchmark\n");
+        return 1;
+    }
+    wavFileInfo info = {.sample_rate = BENCH_RATE, .num_channels = 1, .bits_per_sample = 16};
+
+    char* names[NUM_ENGINES] = {"fft", "yin", "hps", "goertzel", "cqt", "sdft"};
+    printf("%d samples per note, keys %d-%d\n", length, BENCH_LOW_KEY, BENCH_HIGH_KEY);
+    printf("engine     hits  octave  other   ms/note\n");
+    for (int type = 0; type < NUM_ENGINES; type++)
+    {
+        PitchEngine* engine = pitchEngineAlloc(type, BENCH_RATE);
+        if (engine == NULL)
+        {
+            printf("Error setting up the %s engine\n", names[type]);
+            return 1;
+        }
+        FFTPlan plan = {0};
+        int hits = 0;
+        int octaves = 0;
+        int others = 0;
+        clock_t elapsed = 0;
+        for (int key_number = BENCH_LOW_KEY; key_number <= BENCH_HIGH_KEY; key_number++)
+        {
+            synthesize(data, length, key_number, BENCH_RATE);
+            for (int i = length; i < current_size; i++)
+                data[i] = 0;
+
+            clock_t start = clock();
+            int found = analyzeNote(engine, &plan, data, NULL, &info, length, current_size);
+            elapsed += clock() - start;
+
+            if (found == key_number)
+                hits++;
+            else if (found > 0 && (found - key_number) % 12 == 0)
+                octaves++;
+            else
+                others++;
+        }
+        int num_notes = BENCH_HIGH_KEY - BENCH_LOW_KEY + 1;
+        printf("%-8s %6d %7d %6d %9.3f\n", names[type], hits, octaves, others,
+                1000.0 * elapsed / CLOCKS_PER_SEC / num_notes);
+        fftPlanFree(&plan);
+        pitchEngineFree(engine);
+    }
+
+    free(data);
+    return 0;
+}
+
+/**
+*   Fills data with a vibrato tone at the pitch of the given key, second harmonic strongest
+**/
+void synthesize(float data[], int length, int key_number, int sample_rate)
+{
+    double amplitudes[5] = {.6, 1, .5, .3, .2};
+    double frequency = 440 * pow(2, (key_number - 49) / 12.0);
+    double phase = 0;
+
+    for (int i = 0; i < length; i++)
+    {
+        // 5 Hz vibrato, a fifth of a semitone wide
+        double t = (double) i / sample_rate;
+        phase += 2 * M_PI * frequency * pow(2, .1 / 12 * sin(2 * M_PI * 5 * t)) / sample_rate;
+
+        data[i] = 0;
+        for (int h = 0; h < 5; h++)
+            data[i] += 4000 * amplitudes[h] * sin((h + 1) * phase);
+    }
+}
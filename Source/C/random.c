@@ -0,0 +1,50 @@
+/********************************************************************************
+ *
+ * Random Numbers
+ *
+ *  © Phil Ngo, Tyler Clites 2012
+ *
+ * rand() draws from one sequence for the whole program, so threads that use it
+ * take turns, and what any one of them gets depends on the others. An Rng is a
+ * generator of its own (xorshift64*), small enough to keep one per thread or
+ * per candidate, and the same seed always gives the same numbers. Everything
+ * that chooses at random is handed one, so a run with a given seed can be
+ * repeated exactly.
+ *
+********************************************************************************/
+
+#include "musicxml.h"
+
+/**
+*   Returns a generator started from seed. Seeds that are close give unrelated numbers
+**/
+Rng rngOf(uint64_t seed)
+{
+    // splitmix64, so that seed, seed + 1 ... start far apart. the state can't be 0
+    uint64_t z = seed + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+
+    Rng rng = {.state = (z != 0) ? z : 0x9E3779B97F4A7C15ULL};
+    return rng;
+}
+
+/**
+*   Returns the next 32 random bits
+**/
+uint32_t rngNext(Rng* rng)
+{
+    rng->state ^= rng->state >> 12;
+    rng->state ^= rng->state << 25;
+    rng->state ^= rng->state >> 27;
+    return (rng->state * 0x2545F4914F6CDD1DULL) >> 32;
+}
+
+/**
+*   Returns a random number from 0 to n - 1, for n > 0
+**/
+int rngBelow(Rng* rng, int n)
+{
+    return ((uint64_t) rngNext(rng) * (uint64_t) n) >> 32;
+}
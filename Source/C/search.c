@@ -0,0 +1,293 @@
+/********************************************************************************
+ *
+ * Harmony Search
+ *
+ *  © Phil Ngo, Tyler Clites 2012
+ *
+ * determineHarmony() finds the one progression the melody suggests most, and
+ * getCounterpointPart() picks a voicing for it at random. A search instead draws
+ * many harmonizations, harmony and voices together, each candidate from a
+ * generator of its own, and keeps the one with the lowest cost. The candidates
+ * are shared out between threads, so more cores try more of them in the same
+ * time, and candidate c is always the same whichever thread draws it.
+ *
+********************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "musicxml.h"
+
+/**
+*   Returns seconds on a clock that only goes forward
+**/
+double searchClock(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/**
+*   Returns a harmony drawn at random for the rhythm, NULL if memory runs out
+**/
+ChordTimeline* sampleHarmony(Timeline* rhythm, int bins[][7], Rng* rng, Arena* arena)
+{
+    int rhythm_node_count = rhythm->length;
+    ChordTimeline* chords = chordTimelineAlloc(rhythm_node_count, arena);
+    if (chords == NULL)
+        return NULL;
+
+    // start on the tonic, then weigh each chord allowed next by the square of how strongly
+    // the melody suggests it, plus one so that none is left out. the chord before the last
+    // has to be one that can go to the tonic, and the last is the tonic
+    int chord = 0;
+    for (int i = 0; i < rhythm_node_count; i++)
+    {
+        if (i > 0 && i < rhythm_node_count - 1)
+        {
+            int weight[7];
+            int total = 0;
+            for (int j = 0; j < 7; j++)
+            {
+                weight[j] = 0;
+                if (allowedChordProgression(chord, j) &&
+                        (i < rhythm_node_count - 2 || allowedChordProgression(j, 0)))
+                    weight[j] = (bins[i][j] + 1) * (bins[i][j] + 1);
+                total += weight[j];
+            }
+
+            // every chord can reach the tonic in two steps, but be safe
+            if (total == 0)
+                chord = 0;
+            else
+            {
+                int pick = rngBelow(rng, total);
+                chord = 0;
+                while (pick >= weight[chord])
+                    pick -= weight[chord++];
+            }
+        }
+        else
+            chord = 0;
+
+        if (chordTimelineAppend(chords, chord + 1, diatonic_types[chord], 0, rhythm->duration[i]) != 0)
+        {
+            chordTimelineFree(chords);
+            return NULL;
+        }
+    }
+    return chords;
+}
+
+/**
+*   Returns the cost of a harmony and its voices, lower is better
+**/
+int harmonizationCost(ChordTimeline* harmony, int bins[][7], Timeline* parts[], int num_parts)
+{
+    int cost = 0;
+
+    // how far each chord falls short of the one the melody suggests most there
+    for (int i = 0; i < harmony->length; i++)
+    {
+        int most = 0;
+        for (int j = 0; j < 7; j++)
+            if (bins[i][j] > most)
+                most = bins[i][j];
+        cost += (most - bins[i][harmony->function[i] - 1]) * COST_FIT;
+    }
+
+    // the progression rules, and the tonic at either end
+    if (harmony->length > 0 && (harmony->function[0] != 1 || harmony->function[harmony->length - 1] != 1))
+        cost += COST_PROGRESSION;
+    for (int i = 1; i < harmony->length; i++)
+        if (!allowedChordProgression(harmony->function[i - 1] - 1, harmony->function[i] - 1))
+            cost += COST_PROGRESSION;
+
+    // voices below the melody should move by step
+    for (int p = 1; p < num_parts; p++)
+    {
+        for (int n = 1; n < parts[p]->length; n++)
+        {
+            int leap = abs(parts[p]->note_num[n] - parts[p]->note_num[n - 1]);
+            if (leap > 2)
+                cost += (leap - 2) * COST_LEAP;
+        }
+    }
+    return cost;
+}
+
+/**
+*   Tries candidates first, first + step ... of a search until the budget runs out,
+*   keeping the cheapest. Returns NULL
+**/
+void* searchCandidates(void* worker)
+{
+    SearchWorker* search = worker;
+    int limit = (search->settings.candidates > 0) ? search->settings.candidates : -1;
+
+    for (int c = search->first; limit < 0 || c < limit; c += search->step)
+    {
+        // every thread tries at least one, however short the time
+        if (search->tried > 0 && search->deadline > 0 && searchClock() >= search->deadline)
+            break;
+
+        // each candidate has its own numbers and its own memory
+        Rng rng = rngOf(search->settings.seed + c);
+        Arena* arena = arenaAlloc();
+        ChordTimeline* harmony = (arena != NULL) ? sampleHarmony(search->rhythm, search->bins, &rng, arena) : NULL;
+        if (harmony == NULL)
+        {
+            printf("Error allocating memory.\n");
+            arenaFree(arena);
+            search->error = 1;
+            break;
+        }
+        Timeline* parts[4] = {search->part, NULL, NULL, NULL};
+        for (int i = 1; i < search->num_parts && parts[i - 1] != NULL; i++)
+            parts[i] = getCounterpointTimeline(harmony, search->rhythm, parts, i, search->key, 2, &rng);
+        if (parts[search->num_parts - 1] == NULL)
+        {
+            arenaFree(arena);
+            search->error = 1;
+            break;
+        }
+        search->tried++;
+
+        // the earlier candidate wins a tie, so a thread keeps the first of its cheapest
+        int cost = harmonizationCost(harmony, search->bins, parts, search->num_parts);
+        if (search->best < 0 || cost < search->best_cost)
+        {
+            arenaFree(search->arena);
+            search->arena = arena;
+            search->harmony = harmony;
+            for (int i = 0; i < search->num_parts; i++)
+                search->parts[i] = parts[i];
+            search->best = c;
+            search->best_cost = cost;
+        }
+        else
+            arenaFree(arena);
+    }
+    return NULL;
+}
+
+/**
+*   A copy of a timeline from another arena
+**/
+static Timeline* copyTimeline(Timeline* timeline, Arena* arena)
+{
+    Timeline* copy = timelineAlloc(timeline->length, arena);
+    if (copy == NULL)
+        return NULL;
+    for (int i = 0; i < timeline->length; i++)
+    {
+        if (timelineAppend(copy, timeline->note_num[i], timeline->duration[i], timeline->staff[i], timeline->rest[i]) != 0)
+        {
+            timelineFree(copy);
+            return NULL;
+        }
+    }
+    return copy;
+}
+
+/**
+*   Searches for the cheapest harmonization of a melody. Returns its cost, -1 on error
+**/
+int searchHarmonization(Timeline* part, Timeline* rhythm, int key, int beats, int num_parts, SearchSettings settings, ChordTimeline** harmony, Timeline* parts[], int* tried)
+{
+    // error checking
+    if (part == NULL || rhythm == NULL || part->length == 0 || rhythm->length == 0)
+    {
+        printf("Error searching for a harmony: no part or no rhythm\n");
+        return -1;
+    }
+    if (num_parts < 1 || num_parts > 4)
+    {
+        printf("Error searching for a harmony: bad number of parts\n");
+        return -1;
+    }
+    if (settings.candidates <= 0 && settings.seconds <= 0)
+        settings.candidates = SEARCH_CANDIDATES;
+
+    // what the melody suggests is the same for every candidate, so find it once
+    int (*bins)[7] = arenaMalloc(part->arena, sizeof(int[7]) * rhythm->length);
+    if (bins == NULL)
+    {
+        printf("Error allocating memory.\n");
+        return -1;
+    }
+    if (harmonyWeights(part, rhythm, key, beats, 0, rhythm->length, bins) != 0)
+    {
+        arenaRelease(part->arena, bins);
+        return -1;
+    }
+
+    // candidate c goes to thread c % num_threads
+    int num_threads = (settings.num_threads > 0) ? settings.num_threads : numProcessors();
+    if (num_threads > MAX_THREADS)
+        num_threads = MAX_THREADS;
+    if (settings.candidates > 0 && num_threads > settings.candidates)
+        num_threads = settings.candidates;
+    SearchWorker* workers = malloc(sizeof(SearchWorker) * num_threads);
+    void** args = malloc(sizeof(void*) * num_threads);
+    if (workers == NULL || args == NULL)
+    {
+        printf("Error allocating memory.\n");
+        free(workers);
+        free(args);
+        arenaRelease(part->arena, bins);
+        return -1;
+    }
+    double deadline = (settings.seconds > 0) ? searchClock() + settings.seconds : 0;
+    for (int i = 0; i < num_threads; i++)
+    {
+        workers[i] = (SearchWorker) {.part = part, .rhythm = rhythm, .bins = bins, .key = key,
+                .num_parts = num_parts, .settings = settings, .deadline = deadline, .first = i,
+                .step = num_threads, .tried = 0, .best = -1, .best_cost = 0, .arena = NULL,
+                .harmony = NULL, .error = 0};
+        args[i] = &workers[i];
+    }
+    runThreads(num_threads, searchCandidates, args);
+
+    // the cheapest of all, the earliest candidate on a tie
+    SearchWorker* best = NULL;
+    int error = 0;
+    if (tried != NULL)
+        *tried = 0;
+    for (int i = 0; i < num_threads; i++)
+    {
+        error |= workers[i].error;
+        if (tried != NULL)
+            *tried += workers[i].tried;
+        if (workers[i].best >= 0 && (best == NULL || workers[i].best_cost < best->best_cost ||
+                (workers[i].best_cost == best->best_cost && workers[i].best < best->best)))
+            best = &workers[i];
+    }
+
+    // bring the winner over to the melody's arena
+    int cost = -1;
+    if (best != NULL && !error)
+    {
+        *harmony = chordTimelineAlloc(best->harmony->length, part->arena);
+        for (int i = 0; *harmony != NULL && i < best->harmony->length; i++)
+            chordTimelineAppend(*harmony, best->harmony->function[i], best->harmony->type_id[i],
+                    best->harmony->inversion[i], best->harmony->duration[i]);
+        parts[0] = part;
+        cost = (*harmony != NULL) ? best->best_cost : -1;
+        for (int i = 1; i < num_parts; i++)
+        {
+            parts[i] = copyTimeline(best->parts[i], part->arena);
+            if (parts[i] == NULL)
+                cost = -1;
+        }
+        if (cost < 0)
+            printf("Error allocating memory.\n");
+    }
+
+    for (int i = 0; i < num_threads; i++)
+        arenaFree(workers[i].arena);
+    free(workers);
+    free(args);
+    arenaRelease(part->arena, bins);
+    return cost;
+}
@@ -0,0 +1,478 @@
+/********************************************************************************
+ *
+ * Lookup Tables
+ *
+ *  © Phil Ngo, Tyler Clites 2012
+ *
+ * The constant tables the note, chord and harmony functions share. They are
+ * filled in by the compiler, once, instead of on the stack every time one of
+ * those functions is called, and every function reads the same copy.
+ *
+ * Keys run from -7 to 7 (the number of sharps, negative for flats). Add 7 to a
+ * key to index a table by it:
+ *      0  1  2  3  4  5  6  7  8  9  10 11 12 13 14
+ *      Cb Gb Db Ab Eb Bb F  C  G  D  A  E  B  F# C#
+ * Functions run from 1 to 7, subtract 1 to index a table by one.
+ *
+********************************************************************************/
+
+#include "musicxml.h"
+
+// semitones from the tonic of each key up to C
+const int norm_to_C[15] = {1, 6, 11, 4, 9, 2, 7, 0, 5, 10, 3, 8, 1, 6, 11};
+
+// semitones from C up to the tonic of each key
+const int norm_from_C[15] = {11, 6, 1, 8, 3, 10, 5, 0, 7, 2, 9, 4, 11, 6, 1};
+
+// semitones from the tonic of each key up to A, the pitch class of key 1
+const int norm_factor[15] = {10, 3, 8, 1, 6, 11, 4, 9, 2, 7, 0, 5, 10, 3, 8};
+
+// semitones from the root of each diatonic chord up to the tonic
+const int diatonic_adjust[7] = {0, 10, 8, 7, 5, 3, 1};
+
+// semitones from the tonic up to the root of each diatonic chord
+const int function_offsets[7] = {0, 2, 4, 5, 7, 9, 11};
+
+// the type of each diatonic chord: major, minor or diminished
+const int diatonic_types[7] = {0, 1, 1, 0, 0, 1, 2};
+
+// the chords that can harmonize a note, by key + 7 and key number mod 12 (0 is G#).
+// bit f - 1 is set for function f. a note of the scale can be the root, third or
+// fifth of a diatonic chord. a note outside it fits none of them, and the harmony
+// only builds diatonic chords, so it gets none
+const uint8_t chord_candidates[15][12] = {{0x2A, 0x00, 0x54, 0x29, 0x00, 0x52, 0x00, 0x25, 0x4A, 0x00, 0x15, 0x00},  // Cb
+                                          {0x52, 0x00, 0x25, 0x4A, 0x00, 0x15, 0x00, 0x2A, 0x00, 0x54, 0x29, 0x00},  // Gb
+                                          {0x15, 0x00, 0x2A, 0x00, 0x54, 0x29, 0x00, 0x52, 0x00, 0x25, 0x4A, 0x00},  // Db
+                                          {0x29, 0x00, 0x52, 0x00, 0x25, 0x4A, 0x00, 0x15, 0x00, 0x2A, 0x00, 0x54},  // Ab
+                                          {0x4A, 0x00, 0x15, 0x00, 0x2A, 0x00, 0x54, 0x29, 0x00, 0x52, 0x00, 0x25},  // Eb
+                                          {0x00, 0x54, 0x29, 0x00, 0x52, 0x00, 0x25, 0x4A, 0x00, 0x15, 0x00, 0x2A},  // Bb
+                                          {0x00, 0x25, 0x4A, 0x00, 0x15, 0x00, 0x2A, 0x00, 0x54, 0x29, 0x00, 0x52},  // F
+                                          {0x00, 0x2A, 0x00, 0x54, 0x29, 0x00, 0x52, 0x00, 0x25, 0x4A, 0x00, 0x15},  // C
+                                          {0x00, 0x52, 0x00, 0x25, 0x4A, 0x00, 0x15, 0x00, 0x2A, 0x00, 0x54, 0x29},  // G
+                                          {0x00, 0x15, 0x00, 0x2A, 0x00, 0x54, 0x29, 0x00, 0x52, 0x00, 0x25, 0x4A},  // D
+                                          {0x54, 0x29, 0x00, 0x52, 0x00, 0x25, 0x4A, 0x00, 0x15, 0x00, 0x2A, 0x00},  // A
+                                          {0x25, 0x4A, 0x00, 0x15, 0x00, 0x2A, 0x00, 0x54, 0x29, 0x00, 0x52, 0x00},  // E
+                                          {0x2A, 0x00, 0x54, 0x29, 0x00, 0x52, 0x00, 0x25, 0x4A, 0x00, 0x15, 0x00},  // B
+                                          {0x52, 0x00, 0x25, 0x4A, 0x00, 0x15, 0x00, 0x2A, 0x00, 0x54, 0x29, 0x00},  // F#
+                                          {0x15, 0x00, 0x2A, 0x00, 0x54, 0x29, 0x00, 0x52, 0x00, 0x25, 0x4A, 0x00}};  // C#
+
+// which chords can follow a given chord, by function - 1
+const int allowed_progressions[7][7] = {{1,1,1,1,1,1,1},
+                                        {0,1,0,0,1,0,1},
+                                        {0,1,1,1,0,1,0},
+                                        {1,0,0,1,1,0,1},
+                                        {1,0,0,0,1,1,0},
+                                        {0,1,0,1,0,1,0},
+                                        {1,0,0,0,0,0,1}};
+
+// bit i is set if the chord type has the note i semitones above its root
+const uint16_t type_notes[14] = {
+    0x091,      // major: 0 4 7
+    0x089,      // minor: 0 3 7
+    0x049,      // diminished: 0 3 6
+    0x111,      // augmented: 0 4 8
+    0x891,      // major 7th: 0 4 7 11
+    0x491,      // dom 7th: 0 4 7 10
+    0x489,      // min 7th: 0 3 7 10
+    0x449,      // half dim 7th: 0 3 6 10
+    0x249,      // dim 7th: 0 3 6 9
+    0x889,      // min maj 7th: 0 3 7 11
+    0x848,      // flat major: 11 3 6
+    0x844,      // flat minor: 11 2 6
+    0x122,      // sharp major: 1 5 8
+    0x112};     // sharp minor: 1 4 8
+
+// the step (C = 0, D = 1 ...) and alter of each pitch class above C, spelled with sharps or with flats
+const int sharp_steps[12] = {0,0,1,1,2,3,3,4,4,5,5,6};
+const int flat_steps[12] =  {0,1,1,2,2,3,4,4,5,5,6,6};
+const int sharp_alters[12] = {0,1,0,1,0,0,1,0,1,0,1,0};
+const int flat_alters[12] = {0,-1,0,-1,0,0,-1,0,-1,0,-1,0};
+
+// the accidental a key needs in each key signature, by key number mod 12.
+// 1 is a sharp, -1 a flat, 2 a natural and 0 none
+const int accidentals[15][12] = {{0,2,0,0,2,0,2,0,0,2,0,2},
+                                 {0,2,0,0,2,0,2,0,0,0,0,2},
+                                 {0,2,0,2,0,0,2,0,2,0,0,2},
+                                 {0,2,0,2,0,0,2,0,2,0,-1,0},
+                                 {0,2,0,2,0,-1,0,0,2,0,-1,0},
+                                 {-1,0,0,2,0,-1,0,0,2,0,-1,0},
+                                 {-1,0,0,2,0,-1,0,-1,0,0,-1,0},
+                                 {1,0,1,0,0,1,0,1,0,0,1,0},
+                                 {1,0,1,0,0,1,0,1,0,2,0,0},
+                                 {1,0,1,0,2,0,0,1,0,2,0,0},
+                                 {0,0,1,0,2,0,0,1,0,2,0,2},
+                                 {0,0,1,0,2,0,2,0,0,2,0,2},
+                                 {0,2,0,0,2,0,2,0,0,2,0,2},
+                                 {0,2,0,0,2,0,2,0,2,0,0,2},
+                                 {0,2,0,2,0,0,2,0,2,0,0,2}};
+
+// semitones from a key up to its first five harmonics
+const int harmonic_offsets[5] = {0, 12, 19, 24, 28};
+
+// roman numerals, by chord type and function - 1
+const char* const numerals[10][7] = {{"I", "II", "III", "IV", "V", "VI", "VII"},
+                                     {"i", "ii", "iii", "iv", "v", "vi", "vii"},
+                                     {"i°", "ii°", "iii°", "iv°", "v°", "vi°", "vii°"},
+                                     {"I+", "II+", "III+", "IV+", "V+", "vi+", "vii+"},
+                                     {"Imaj7", "IImaj7", "IIImaj7", "IVmaj7", "Vmaj7", "VImaj7", "VIImaj7"},
+                                     {"I7", "II7", "III7", "IV7", "V7", "VI7", "VII7"},
+                                     {"i7", "ii7", "iii7", "iv7", "v7", "vi7", "vii7"},
+                                     {"i°7", "ii°7", "iii°7", "iv°7", "v°7", "vi°7", "vii°7"},
+                                     {"iø7", "iiø7", "iiiø7", "ivø7", "vø7", "viø7", "viiø7"},
+                                     {"I∆7", "II∆7", "III∆7", "IV∆7", "V∆7", "VI∆7", "V∆7"}};
+
+// every piano key in every key signature, as getNote() returns it:
+// {octave, step, alter, accidental}, key signatures from Cb to C#
+const Note note_table[88][15] = {
+    // key 1: A0
+    {{0,5,0,2}, {0,5,0,2}, {0,5,0,2}, {0,5,0,2}, {0,5,0,2},
+     {0,5,0,0}, {0,5,0,0}, {0,5,0,0}, {0,5,0,0}, {0,5,0,0},
+     {0,5,0,0}, {0,5,0,0}, {0,5,0,2}, {0,5,0,2}, {0,5,0,2}},
+    // key 2: A#/Bb0
+    {{0,6,-1,0}, {0,6,-1,0}, {0,6,-1,0}, {0,6,-1,0}, {0,6,-1,0},
+     {0,6,-1,0}, {0,6,-1,0}, {0,5,1,1}, {0,5,1,1}, {0,5,1,1},
+     {0,5,1,1}, {0,5,1,1}, {0,5,1,0}, {0,5,1,0}, {0,5,1,0}},
+    // key 3: B0
+    {{0,6,0,0}, {0,6,0,0}, {0,6,0,2}, {0,6,0,2}, {0,6,0,2},
+     {0,6,0,2}, {0,6,0,2}, {0,6,0,0}, {0,6,0,0}, {0,6,0,0},
+     {0,6,0,0}, {0,6,0,0}, {0,6,0,0}, {0,6,0,0}, {0,6,0,2}},
+    // key 4: C1
+    {{1,0,0,2}, {1,0,0,2}, {1,0,0,0}, {1,0,0,0}, {1,0,0,0},
+     {1,0,0,0}, {1,0,0,0}, {1,0,0,0}, {1,0,0,0}, {1,0,0,2},
+     {1,0,0,2}, {1,0,0,2}, {1,0,0,2}, {1,0,0,2}, {1,0,0,0}},
+    // key 5: C#/Db1
+    {{1,1,-1,0}, {1,1,-1,0}, {1,1,-1,0}, {1,1,-1,0}, {1,1,-1,-1},
+     {1,1,-1,-1}, {1,1,-1,-1}, {1,0,1,1}, {1,0,1,1}, {1,0,1,0},
+     {1,0,1,0}, {1,0,1,0}, {1,0,1,0}, {1,0,1,0}, {1,0,1,0}},
+    // key 6: D1
+    {{1,1,0,2}, {1,1,0,2}, {1,1,0,2}, {1,1,0,2}, {1,1,0,0},
+     {1,1,0,0}, {1,1,0,0}, {1,1,0,0}, {1,1,0,0}, {1,1,0,0},
+     {1,1,0,0}, {1,1,0,2}, {1,1,0,2}, {1,1,0,2}, {1,1,0,2}},
+    // key 7: D#/Eb1
+    {{1,2,-1,0}, {1,2,-1,0}, {1,2,-1,0}, {1,2,-1,0}, {1,2,-1,0},
+     {1,2,-1,0}, {1,2,-1,-1}, {1,1,1,1}, {1,1,1,1}, {1,1,1,1},
+     {1,1,1,1}, {1,1,1,0}, {1,1,1,0}, {1,1,1,0}, {1,1,1,0}},
+    // key 8: E1
+    {{1,2,0,0}, {1,2,0,0}, {1,2,0,2}, {1,2,0,2}, {1,2,0,2},
+     {1,2,0,2}, {1,2,0,0}, {1,2,0,0}, {1,2,0,0}, {1,2,0,0},
+     {1,2,0,0}, {1,2,0,0}, {1,2,0,0}, {1,2,0,2}, {1,2,0,2}},
+    // key 9: F1
+    {{1,3,0,2}, {1,3,0,0}, {1,3,0,0}, {1,3,0,0}, {1,3,0,0},
+     {1,3,0,0}, {1,3,0,0}, {1,3,0,0}, {1,3,0,2}, {1,3,0,2},
+     {1,3,0,2}, {1,3,0,2}, {1,3,0,2}, {1,3,0,0}, {1,3,0,0}},
+    // key 10: F#/Gb1
+    {{1,4,-1,0}, {1,4,-1,0}, {1,4,-1,0}, {1,4,-1,-1}, {1,4,-1,-1},
+     {1,4,-1,-1}, {1,4,-1,-1}, {1,3,1,1}, {1,3,1,0}, {1,3,1,0},
+     {1,3,1,0}, {1,3,1,0}, {1,3,1,0}, {1,3,1,0}, {1,3,1,0}},
+    // key 11: G1
+    {{1,4,0,2}, {1,4,0,2}, {1,4,0,2}, {1,4,0,0}, {1,4,0,0},
+     {1,4,0,0}, {1,4,0,0}, {1,4,0,0}, {1,4,0,0}, {1,4,0,0},
+     {1,4,0,2}, {1,4,0,2}, {1,4,0,2}, {1,4,0,2}, {1,4,0,2}},
+    // key 12: G#/Ab1
+    {{1,5,-1,0}, {1,5,-1,0}, {1,5,-1,0}, {1,5,-1,0}, {1,5,-1,0},
+     {1,5,-1,-1}, {1,5,-1,-1}, {1,4,1,1}, {1,4,1,1}, {1,4,1,1},
+     {1,4,1,0}, {1,4,1,0}, {1,4,1,0}, {1,4,1,0}, {1,4,1,0}},
+    // key 13: A1
+    {{1,5,0,2}, {1,5,0,2}, {1,5,0,2}, {1,5,0,2}, {1,5,0,2},
+     {1,5,0,0}, {1,5,0,0}, {1,5,0,0}, {1,5,0,0}, {1,5,0,0},
+     {1,5,0,0}, {1,5,0,0}, {1,5,0,2}, {1,5,0,2}, {1,5,0,2}},
+    // key 14: A#/Bb1
+    {{1,6,-1,0}, {1,6,-1,0}, {1,6,-1,0}, {1,6,-1,0}, {1,6,-1,0},
+     {1,6,-1,0}, {1,6,-1,0}, {1,5,1,1}, {1,5,1,1}, {1,5,1,1},
+     {1,5,1,1}, {1,5,1,1}, {1,5,1,0}, {1,5,1,0}, {1,5,1,0}},
+    // key 15: B1
+    {{1,6,0,0}, {1,6,0,0}, {1,6,0,2}, {1,6,0,2}, {1,6,0,2},
+     {1,6,0,2}, {1,6,0,2}, {1,6,0,0}, {1,6,0,0}, {1,6,0,0},
+     {1,6,0,0}, {1,6,0,0}, {1,6,0,0}, {1,6,0,0}, {1,6,0,2}},
+    // key 16: C2
+    {{2,0,0,2}, {2,0,0,2}, {2,0,0,0}, {2,0,0,0}, {2,0,0,0},
+     {2,0,0,0}, {2,0,0,0}, {2,0,0,0}, {2,0,0,0}, {2,0,0,2},
+     {2,0,0,2}, {2,0,0,2}, {2,0,0,2}, {2,0,0,2}, {2,0,0,0}},
+    // key 17: C#/Db2
+    {{2,1,-1,0}, {2,1,-1,0}, {2,1,-1,0}, {2,1,-1,0}, {2,1,-1,-1},
+     {2,1,-1,-1}, {2,1,-1,-1}, {2,0,1,1}, {2,0,1,1}, {2,0,1,0},
+     {2,0,1,0}, {2,0,1,0}, {2,0,1,0}, {2,0,1,0}, {2,0,1,0}},
+    // key 18: D2
+    {{2,1,0,2}, {2,1,0,2}, {2,1,0,2}, {2,1,0,2}, {2,1,0,0},
+     {2,1,0,0}, {2,1,0,0}, {2,1,0,0}, {2,1,0,0}, {2,1,0,0},
+     {2,1,0,0}, {2,1,0,2}, {2,1,0,2}, {2,1,0,2}, {2,1,0,2}},
+    // key 19: D#/Eb2
+    {{2,2,-1,0}, {2,2,-1,0}, {2,2,-1,0}, {2,2,-1,0}, {2,2,-1,0},
+     {2,2,-1,0}, {2,2,-1,-1}, {2,1,1,1}, {2,1,1,1}, {2,1,1,1},
+     {2,1,1,1}, {2,1,1,0}, {2,1,1,0}, {2,1,1,0}, {2,1,1,0}},
+    // key 20: E2
+    {{2,2,0,0}, {2,2,0,0}, {2,2,0,2}, {2,2,0,2}, {2,2,0,2},
+     {2,2,0,2}, {2,2,0,0}, {2,2,0,0}, {2,2,0,0}, {2,2,0,0},
+     {2,2,0,0}, {2,2,0,0}, {2,2,0,0}, {2,2,0,2}, {2,2,0,2}},
+    // key 21: F2
+    {{2,3,0,2}, {2,3,0,0}, {2,3,0,0}, {2,3,0,0}, {2,3,0,0},
+     {2,3,0,0}, {2,3,0,0}, {2,3,0,0}, {2,3,0,2}, {2,3,0,2},
+     {2,3,0,2}, {2,3,0,2}, {2,3,0,2}, {2,3,0,0}, {2,3,0,0}},
+    // key 22: F#/Gb2
+    {{2,4,-1,0}, {2,4,-1,0}, {2,4,-1,0}, {2,4,-1,-1}, {2,4,-1,-1},
+     {2,4,-1,-1}, {2,4,-1,-1}, {2,3,1,1}, {2,3,1,0}, {2,3,1,0},
+     {2,3,1,0}, {2,3,1,0}, {2,3,1,0}, {2,3,1,0}, {2,3,1,0}},
+    // key 23: G2
+    {{2,4,0,2}, {2,4,0,2}, {2,4,0,2}, {2,4,0,0}, {2,4,0,0},
+     {2,4,0,0}, {2,4,0,0}, {2,4,0,0}, {2,4,0,0}, {2,4,0,0},
+     {2,4,0,2}, {2,4,0,2}, {2,4,0,2}, {2,4,0,2}, {2,4,0,2}},
+    // key 24: G#/Ab2
+    {{2,5,-1,0}, {2,5,-1,0}, {2,5,-1,0}, {2,5,-1,0}, {2,5,-1,0},
+     {2,5,-1,-1}, {2,5,-1,-1}, {2,4,1,1}, {2,4,1,1}, {2,4,1,1},
+     {2,4,1,0}, {2,4,1,0}, {2,4,1,0}, {2,4,1,0}, {2,4,1,0}},
+    // key 25: A2
+    {{2,5,0,2}, {2,5,0,2}, {2,5,0,2}, {2,5,0,2}, {2,5,0,2},
+     {2,5,0,0}, {2,5,0,0}, {2,5,0,0}, {2,5,0,0}, {2,5,0,0},
+     {2,5,0,0}, {2,5,0,0}, {2,5,0,2}, {2,5,0,2}, {2,5,0,2}},
+    // key 26: A#/Bb2
+    {{2,6,-1,0}, {2,6,-1,0}, {2,6,-1,0}, {2,6,-1,0}, {2,6,-1,0},
+     {2,6,-1,0}, {2,6,-1,0}, {2,5,1,1}, {2,5,1,1}, {2,5,1,1},
+     {2,5,1,1}, {2,5,1,1}, {2,5,1,0}, {2,5,1,0}, {2,5,1,0}},
+    // key 27: B2
+    {{2,6,0,0}, {2,6,0,0}, {2,6,0,2}, {2,6,0,2}, {2,6,0,2},
+     {2,6,0,2}, {2,6,0,2}, {2,6,0,0}, {2,6,0,0}, {2,6,0,0},
+     {2,6,0,0}, {2,6,0,0}, {2,6,0,0}, {2,6,0,0}, {2,6,0,2}},
+    // key 28: C3
+    {{3,0,0,2}, {3,0,0,2}, {3,0,0,0}, {3,0,0,0}, {3,0,0,0},
+     {3,0,0,0}, {3,0,0,0}, {3,0,0,0}, {3,0,0,0}, {3,0,0,2},
+     {3,0,0,2}, {3,0,0,2}, {3,0,0,2}, {3,0,0,2}, {3,0,0,0}},
+    // key 29: C#/Db3
+    {{3,1,-1,0}, {3,1,-1,0}, {3,1,-1,0}, {3,1,-1,0}, {3,1,-1,-1},
+     {3,1,-1,-1}, {3,1,-1,-1}, {3,0,1,1}, {3,0,1,1}, {3,0,1,0},
+     {3,0,1,0}, {3,0,1,0}, {3,0,1,0}, {3,0,1,0}, {3,0,1,0}},
+    // key 30: D3
+    {{3,1,0,2}, {3,1,0,2}, {3,1,0,2}, {3,1,0,2}, {3,1,0,0},
+     {3,1,0,0}, {3,1,0,0}, {3,1,0,0}, {3,1,0,0}, {3,1,0,0},
+     {3,1,0,0}, {3,1,0,2}, {3,1,0,2}, {3,1,0,2}, {3,1,0,2}},
+    // key 31: D#/Eb3
+    {{3,2,-1,0}, {3,2,-1,0}, {3,2,-1,0}, {3,2,-1,0}, {3,2,-1,0},
+     {3,2,-1,0}, {3,2,-1,-1}, {3,1,1,1}, {3,1,1,1}, {3,1,1,1},
+     {3,1,1,1}, {3,1,1,0}, {3,1,1,0}, {3,1,1,0}, {3,1,1,0}},
+    // key 32: E3
+    {{3,2,0,0}, {3,2,0,0}, {3,2,0,2}, {3,2,0,2}, {3,2,0,2},
+     {3,2,0,2}, {3,2,0,0}, {3,2,0,0}, {3,2,0,0}, {3,2,0,0},
+     {3,2,0,0}, {3,2,0,0}, {3,2,0,0}, {3,2,0,2}, {3,2,0,2}},
+    // key 33: F3
+    {{3,3,0,2}, {3,3,0,0}, {3,3,0,0}, {3,3,0,0}, {3,3,0,0},
+     {3,3,0,0}, {3,3,0,0}, {3,3,0,0}, {3,3,0,2}, {3,3,0,2},
+     {3,3,0,2}, {3,3,0,2}, {3,3,0,2}, {3,3,0,0}, {3,3,0,0}},
+    // key 34: F#/Gb3
+    {{3,4,-1,0}, {3,4,-1,0}, {3,4,-1,0}, {3,4,-1,-1}, {3,4,-1,-1},
+     {3,4,-1,-1}, {3,4,-1,-1}, {3,3,1,1}, {3,3,1,0}, {3,3,1,0},
+     {3,3,1,0}, {3,3,1,0}, {3,3,1,0}, {3,3,1,0}, {3,3,1,0}},
+    // key 35: G3
+    {{3,4,0,2}, {3,4,0,2}, {3,4,0,2}, {3,4,0,0}, {3,4,0,0},
+     {3,4,0,0}, {3,4,0,0}, {3,4,0,0}, {3,4,0,0}, {3,4,0,0},
+     {3,4,0,2}, {3,4,0,2}, {3,4,0,2}, {3,4,0,2}, {3,4,0,2}},
+    // key 36: G#/Ab3
+    {{3,5,-1,0}, {3,5,-1,0}, {3,5,-1,0}, {3,5,-1,0}, {3,5,-1,0},
+     {3,5,-1,-1}, {3,5,-1,-1}, {3,4,1,1}, {3,4,1,1}, {3,4,1,1},
+     {3,4,1,0}, {3,4,1,0}, {3,4,1,0}, {3,4,1,0}, {3,4,1,0}},
+    // key 37: A3
+    {{3,5,0,2}, {3,5,0,2}, {3,5,0,2}, {3,5,0,2}, {3,5,0,2},
+     {3,5,0,0}, {3,5,0,0}, {3,5,0,0}, {3,5,0,0}, {3,5,0,0},
+     {3,5,0,0}, {3,5,0,0}, {3,5,0,2}, {3,5,0,2}, {3,5,0,2}},
+    // key 38: A#/Bb3
+    {{3,6,-1,0}, {3,6,-1,0}, {3,6,-1,0}, {3,6,-1,0}, {3,6,-1,0},
+     {3,6,-1,0}, {3,6,-1,0}, {3,5,1,1}, {3,5,1,1}, {3,5,1,1},
+     {3,5,1,1}, {3,5,1,1}, {3,5,1,0}, {3,5,1,0}, {3,5,1,0}},
+    // key 39: B3
+    {{3,6,0,0}, {3,6,0,0}, {3,6,0,2}, {3,6,0,2}, {3,6,0,2},
+     {3,6,0,2}, {3,6,0,2}, {3,6,0,0}, {3,6,0,0}, {3,6,0,0},
+     {3,6,0,0}, {3,6,0,0}, {3,6,0,0}, {3,6,0,0}, {3,6,0,2}},
+    // key 40: C4
+    {{4,0,0,2}, {4,0,0,2}, {4,0,0,0}, {4,0,0,0}, {4,0,0,0},
+     {4,0,0,0}, {4,0,0,0}, {4,0,0,0}, {4,0,0,0}, {4,0,0,2},
+     {4,0,0,2}, {4,0,0,2}, {4,0,0,2}, {4,0,0,2}, {4,0,0,0}},
+    // key 41: C#/Db4
+    {{4,1,-1,0}, {4,1,-1,0}, {4,1,-1,0}, {4,1,-1,0}, {4,1,-1,-1},
+     {4,1,-1,-1}, {4,1,-1,-1}, {4,0,1,1}, {4,0,1,1}, {4,0,1,0},
+     {4,0,1,0}, {4,0,1,0}, {4,0,1,0}, {4,0,1,0}, {4,0,1,0}},
+    // key 42: D4
+    {{4,1,0,2}, {4,1,0,2}, {4,1,0,2}, {4,1,0,2}, {4,1,0,0},
+     {4,1,0,0}, {4,1,0,0}, {4,1,0,0}, {4,1,0,0}, {4,1,0,0},
+     {4,1,0,0}, {4,1,0,2}, {4,1,0,2}, {4,1,0,2}, {4,1,0,2}},
+    // key 43: D#/Eb4
+    {{4,2,-1,0}, {4,2,-1,0}, {4,2,-1,0}, {4,2,-1,0}, {4,2,-1,0},
+     {4,2,-1,0}, {4,2,-1,-1}, {4,1,1,1}, {4,1,1,1}, {4,1,1,1},
+     {4,1,1,1}, {4,1,1,0}, {4,1,1,0}, {4,1,1,0}, {4,1,1,0}},
+    // key 44: E4
+    {{4,2,0,0}, {4,2,0,0}, {4,2,0,2}, {4,2,0,2}, {4,2,0,2},
+     {4,2,0,2}, {4,2,0,0}, {4,2,0,0}, {4,2,0,0}, {4,2,0,0},
+     {4,2,0,0}, {4,2,0,0}, {4,2,0,0}, {4,2,0,2}, {4,2,0,2}},
+    // key 45: F4
+    {{4,3,0,2}, {4,3,0,0}, {4,3,0,0}, {4,3,0,0}, {4,3,0,0},
+     {4,3,0,0}, {4,3,0,0}, {4,3,0,0}, {4,3,0,2}, {4,3,0,2},
+     {4,3,0,2}, {4,3,0,2}, {4,3,0,2}, {4,3,0,0}, {4,3,0,0}},
+    // key 46: F#/Gb4
+    {{4,4,-1,0}, {4,4,-1,0}, {4,4,-1,0}, {4,4,-1,-1}, {4,4,-1,-1},
+     {4,4,-1,-1}, {4,4,-1,-1}, {4,3,1,1}, {4,3,1,0}, {4,3,1,0},
+     {4,3,1,0}, {4,3,1,0}, {4,3,1,0}, {4,3,1,0}, {4,3,1,0}},
+    // key 47: G4
+    {{4,4,0,2}, {4,4,0,2}, {4,4,0,2}, {4,4,0,0}, {4,4,0,0},
+     {4,4,0,0}, {4,4,0,0}, {4,4,0,0}, {4,4,0,0}, {4,4,0,0},
+     {4,4,0,2}, {4,4,0,2}, {4,4,0,2}, {4,4,0,2}, {4,4,0,2}},
+    // key 48: G#/Ab4
+    {{4,5,-1,0}, {4,5,-1,0}, {4,5,-1,0}, {4,5,-1,0}, {4,5,-1,0},
+     {4,5,-1,-1}, {4,5,-1,-1}, {4,4,1,1}, {4,4,1,1}, {4,4,1,1},
+     {4,4,1,0}, {4,4,1,0}, {4,4,1,0}, {4,4,1,0}, {4,4,1,0}},
+    // key 49: A4
+    {{4,5,0,2}, {4,5,0,2}, {4,5,0,2}, {4,5,0,2}, {4,5,0,2},
+     {4,5,0,0}, {4,5,0,0}, {4,5,0,0}, {4,5,0,0}, {4,5,0,0},
+     {4,5,0,0}, {4,5,0,0}, {4,5,0,2}, {4,5,0,2}, {4,5,0,2}},
+    // key 50: A#/Bb4
+    {{4,6,-1,0}, {4,6,-1,0}, {4,6,-1,0}, {4,6,-1,0}, {4,6,-1,0},
+     {4,6,-1,0}, {4,6,-1,0}, {4,5,1,1}, {4,5,1,1}, {4,5,1,1},
+     {4,5,1,1}, {4,5,1,1}, {4,5,1,0}, {4,5,1,0}, {4,5,1,0}},
+    // key 51: B4
+    {{4,6,0,0}, {4,6,0,0}, {4,6,0,2}, {4,6,0,2}, {4,6,0,2},
+     {4,6,0,2}, {4,6,0,2}, {4,6,0,0}, {4,6,0,0}, {4,6,0,0},
+     {4,6,0,0}, {4,6,0,0}, {4,6,0,0}, {4,6,0,0}, {4,6,0,2}},
+    // key 52: C5
+    {{5,0,0,2}, {5,0,0,2}, {5,0,0,0}, {5,0,0,0}, {5,0,0,0},
+     {5,0,0,0}, {5,0,0,0}, {5,0,0,0}, {5,0,0,0}, {5,0,0,2},
+     {5,0,0,2}, {5,0,0,2}, {5,0,0,2}, {5,0,0,2}, {5,0,0,0}},
+    // key 53: C#/Db5
+    {{5,1,-1,0}, {5,1,-1,0}, {5,1,-1,0}, {5,1,-1,0}, {5,1,-1,-1},
+     {5,1,-1,-1}, {5,1,-1,-1}, {5,0,1,1}, {5,0,1,1}, {5,0,1,0},
+     {5,0,1,0}, {5,0,1,0}, {5,0,1,0}, {5,0,1,0}, {5,0,1,0}},
+    // key 54: D5
+    {{5,1,0,2}, {5,1,0,2}, {5,1,0,2}, {5,1,0,2}, {5,1,0,0},
+     {5,1,0,0}, {5,1,0,0}, {5,1,0,0}, {5,1,0,0}, {5,1,0,0},
+     {5,1,0,0}, {5,1,0,2}, {5,1,0,2}, {5,1,0,2}, {5,1,0,2}},
+    // key 55: D#/Eb5
+    {{5,2,-1,0}, {5,2,-1,0}, {5,2,-1,0}, {5,2,-1,0}, {5,2,-1,0},
+     {5,2,-1,0}, {5,2,-1,-1}, {5,1,1,1}, {5,1,1,1}, {5,1,1,1},
+     {5,1,1,1}, {5,1,1,0}, {5,1,1,0}, {5,1,1,0}, {5,1,1,0}},
+    // key 56: E5
+    {{5,2,0,0}, {5,2,0,0}, {5,2,0,2}, {5,2,0,2}, {5,2,0,2},
+     {5,2,0,2}, {5,2,0,0}, {5,2,0,0}, {5,2,0,0}, {5,2,0,0},
+     {5,2,0,0}, {5,2,0,0}, {5,2,0,0}, {5,2,0,2}, {5,2,0,2}},
+    // key 57: F5
+    {{5,3,0,2}, {5,3,0,0}, {5,3,0,0}, {5,3,0,0}, {5,3,0,0},
+     {5,3,0,0}, {5,3,0,0}, {5,3,0,0}, {5,3,0,2}, {5,3,0,2},
+     {5,3,0,2}, {5,3,0,2}, {5,3,0,2}, {5,3,0,0}, {5,3,0,0}},
+    // key 58: F#/Gb5
+    {{5,4,-1,0}, {5,4,-1,0}, {5,4,-1,0}, {5,4,-1,-1}, {5,4,-1,-1},
+     {5,4,-1,-1}, {5,4,-1,-1}, {5,3,1,1}, {5,3,1,0}, {5,3,1,0},
+     {5,3,1,0}, {5,3,1,0}, {5,3,1,0}, {5,3,1,0}, {5,3,1,0}},
+    // key 59: G5
+    {{5,4,0,2}, {5,4,0,2}, {5,4,0,2}, {5,4,0,0}, {5,4,0,0},
+     {5,4,0,0}, {5,4,0,0}, {5,4,0,0}, {5,4,0,0}, {5,4,0,0},
+     {5,4,0,2}, {5,4,0,2}, {5,4,0,2}, {5,4,0,2}, {5,4,0,2}},
+    // key 60: G#/Ab5
+    {{5,5,-1,0}, {5,5,-1,0}, {5,5,-1,0}, {5,5,-1,0}, {5,5,-1,0},
+     {5,5,-1,-1}, {5,5,-1,-1}, {5,4,1,1}, {5,4,1,1}, {5,4,1,1},
+     {5,4,1,0}, {5,4,1,0}, {5,4,1,0}, {5,4,1,0}, {5,4,1,0}},
+    // key 61: A5
+    {{5,5,0,2}, {5,5,0,2}, {5,5,0,2}, {5,5,0,2}, {5,5,0,2},
+     {5,5,0,0}, {5,5,0,0}, {5,5,0,0}, {5,5,0,0}, {5,5,0,0},
+     {5,5,0,0}, {5,5,0,0}, {5,5,0,2}, {5,5,0,2}, {5,5,0,2}},
+    // key 62: A#/Bb5
+    {{5,6,-1,0}, {5,6,-1,0}, {5,6,-1,0}, {5,6,-1,0}, {5,6,-1,0},
+     {5,6,-1,0}, {5,6,-1,0}, {5,5,1,1}, {5,5,1,1}, {5,5,1,1},
+     {5,5,1,1}, {5,5,1,1}, {5,5,1,0}, {5,5,1,0}, {5,5,1,0}},
+    // key 63: B5
+    {{5,6,0,0}, {5,6,0,0}, {5,6,0,2}, {5,6,0,2}, {5,6,0,2},
+     {5,6,0,2}, {5,6,0,2}, {5,6,0,0}, {5,6,0,0}, {5,6,0,0},
+     {5,6,0,0}, {5,6,0,0}, {5,6,0,0}, {5,6,0,0}, {5,6,0,2}},
+    // key 64: C6
+    {{6,0,0,2}, {6,0,0,2}, {6,0,0,0}, {6,0,0,0}, {6,0,0,0},
+     {6,0,0,0}, {6,0,0,0}, {6,0,0,0}, {6,0,0,0}, {6,0,0,2},
+     {6,0,0,2}, {6,0,0,2}, {6,0,0,2}, {6,0,0,2}, {6,0,0,0}},
+    // key 65: C#/Db6
+    {{6,1,-1,0}, {6,1,-1,0}, {6,1,-1,0}, {6,1,-1,0}, {6,1,-1,-1},
+     {6,1,-1,-1}, {6,1,-1,-1}, {6,0,1,1}, {6,0,1,1}, {6,0,1,0},
+     {6,0,1,0}, {6,0,1,0}, {6,0,1,0}, {6,0,1,0}, {6,0,1,0}},
+    // key 66: D6
+    {{6,1,0,2}, {6,1,0,2}, {6,1,0,2}, {6,1,0,2}, {6,1,0,0},
+     {6,1,0,0}, {6,1,0,0}, {6,1,0,0}, {6,1,0,0}, {6,1,0,0},
+     {6,1,0,0}, {6,1,0,2}, {6,1,0,2}, {6,1,0,2}, {6,1,0,2}},
+    // key 67: D#/Eb6
+    {{6,2,-1,0}, {6,2,-1,0}, {6,2,-1,0}, {6,2,-1,0}, {6,2,-1,0},
+     {6,2,-1,0}, {6,2,-1,-1}, {6,1,1,1}, {6,1,1,1}, {6,1,1,1},
+     {6,1,1,1}, {6,1,1,0}, {6,1,1,0}, {6,1,1,0}, {6,1,1,0}},
+    // key 68: E6
+    {{6,2,0,0}, {6,2,0,0}, {6,2,0,2}, {6,2,0,2}, {6,2,0,2},
+     {6,2,0,2}, {6,2,0,0}, {6,2,0,0}, {6,2,0,0}, {6,2,0,0},
+     {6,2,0,0}, {6,2,0,0}, {6,2,0,0}, {6,2,0,2}, {6,2,0,2}},
+    // key 69: F6
+    {{6,3,0,2}, {6,3,0,0}, {6,3,0,0}, {6,3,0,0}, {6,3,0,0},
+     {6,3,0,0}, {6,3,0,0}, {6,3,0,0}, {6,3,0,2}, {6,3,0,2},
+     {6,3,0,2}, {6,3,0,2}, {6,3,0,2}, {6,3,0,0}, {6,3,0,0}},
+    // key 70: F#/Gb6
+    {{6,4,-1,0}, {6,4,-1,0}, {6,4,-1,0}, {6,4,-1,-1}, {6,4,-1,-1},
+     {6,4,-1,-1}, {6,4,-1,-1}, {6,3,1,1}, {6,3,1,0}, {6,3,1,0},
+     {6,3,1,0}, {6,3,1,0}, {6,3,1,0}, {6,3,1,0}, {6,3,1,0}},
+    // key 71: G6
+    {{6,4,0,2}, {6,4,0,2}, {6,4,0,2}, {6,4,0,0}, {6,4,0,0},
+     {6,4,0,0}, {6,4,0,0}, {6,4,0,0}, {6,4,0,0}, {6,4,0,0},
+     {6,4,0,2}, {6,4,0,2}, {6,4,0,2}, {6,4,0,2}, {6,4,0,2}},
+    // key 72: G#/Ab6
+    {{6,5,-1,0}, {6,5,-1,0}, {6,5,-1,0}, {6,5,-1,0}, {6,5,-1,0},
+     {6,5,-1,-1}, {6,5,-1,-1}, {6,4,1,1}, {6,4,1,1}, {6,4,1,1},
+     {6,4,1,0}, {6,4,1,0}, {6,4,1,0}, {6,4,1,0}, {6,4,1,0}},
+    // key 73: A6
+    {{6,5,0,2}, {6,5,0,2}, {6,5,0,2}, {6,5,0,2}, {6,5,0,2},
+     {6,5,0,0}, {6,5,0,0}, {6,5,0,0}, {6,5,0,0}, {6,5,0,0},
+     {6,5,0,0}, {6,5,0,0}, {6,5,0,2}, {6,5,0,2}, {6,5,0,2}},
+    // key 74: A#/Bb6
+    {{6,6,-1,0}, {6,6,-1,0}, {6,6,-1,0}, {6,6,-1,0}, {6,6,-1,0},
+     {6,6,-1,0}, {6,6,-1,0}, {6,5,1,1}, {6,5,1,1}, {6,5,1,1},
+     {6,5,1,1}, {6,5,1,1}, {6,5,1,0}, {6,5,1,0}, {6,5,1,0}},
+    // key 75: B6
+    {{6,6,0,0}, {6,6,0,0}, {6,6,0,2}, {6,6,0,2}, {6,6,0,2},
+     {6,6,0,2}, {6,6,0,2}, {6,6,0,0}, {6,6,0,0}, {6,6,0,0},
+     {6,6,0,0}, {6,6,0,0}, {6,6,0,0}, {6,6,0,0}, {6,6,0,2}},
+    // key 76: C7
+    {{7,0,0,2}, {7,0,0,2}, {7,0,0,0}, {7,0,0,0}, {7,0,0,0},
+     {7,0,0,0}, {7,0,0,0}, {7,0,0,0}, {7,0,0,0}, {7,0,0,2},
+     {7,0,0,2}, {7,0,0,2}, {7,0,0,2}, {7,0,0,2}, {7,0,0,0}},
+    // key 77: C#/Db7
+    {{7,1,-1,0}, {7,1,-1,0}, {7,1,-1,0}, {7,1,-1,0}, {7,1,-1,-1},
+     {7,1,-1,-1}, {7,1,-1,-1}, {7,0,1,1}, {7,0,1,1}, {7,0,1,0},
+     {7,0,1,0}, {7,0,1,0}, {7,0,1,0}, {7,0,1,0}, {7,0,1,0}},
+    // key 78: D7
+    {{7,1,0,2}, {7,1,0,2}, {7,1,0,2}, {7,1,0,2}, {7,1,0,0},
+     {7,1,0,0}, {7,1,0,0}, {7,1,0,0}, {7,1,0,0}, {7,1,0,0},
+     {7,1,0,0}, {7,1,0,2}, {7,1,0,2}, {7,1,0,2}, {7,1,0,2}},
+    // key 79: D#/Eb7
+    {{7,2,-1,0}, {7,2,-1,0}, {7,2,-1,0}, {7,2,-1,0}, {7,2,-1,0},
+     {7,2,-1,0}, {7,2,-1,-1}, {7,1,1,1}, {7,1,1,1}, {7,1,1,1},
+     {7,1,1,1}, {7,1,1,0}, {7,1,1,0}, {7,1,1,0}, {7,1,1,0}},
+    // key 80: E7
+    {{7,2,0,0}, {7,2,0,0}, {7,2,0,2}, {7,2,0,2}, {7,2,0,2},
+     {7,2,0,2}, {7,2,0,0}, {7,2,0,0}, {7,2,0,0}, {7,2,0,0},
+     {7,2,0,0}, {7,2,0,0}, {7,2,0,0}, {7,2,0,2}, {7,2,0,2}},
+    // key 81: F7
+    {{7,3,0,2}, {7,3,0,0}, {7,3,0,0}, {7,3,0,0}, {7,3,0,0},
+     {7,3,0,0}, {7,3,0,0}, {7,3,0,0}, {7,3,0,2}, {7,3,0,2},
+     {7,3,0,2}, {7,3,0,2}, {7,3,0,2}, {7,3,0,0}, {7,3,0,0}},
+    // key 82: F#/Gb7
+    {{7,4,-1,0}, {7,4,-1,0}, {7,4,-1,0}, {7,4,-1,-1}, {7,4,-1,-1},
+     {7,4,-1,-1}, {7,4,-1,-1}, {7,3,1,1}, {7,3,1,0}, {7,3,1,0},
+     {7,3,1,0}, {7,3,1,0}, {7,3,1,0}, {7,3,1,0}, {7,3,1,0}},
+    // key 83: G7
+    {{7,4,0,2}, {7,4,0,2}, {7,4,0,2}, {7,4,0,0}, {7,4,0,0},
+     {7,4,0,0}, {7,4,0,0}, {7,4,0,0}, {7,4,0,0}, {7,4,0,0},
+     {7,4,0,2}, {7,4,0,2}, {7,4,0,2}, {7,4,0,2}, {7,4,0,2}},
+    // key 84: G#/Ab7
+    {{7,5,-1,0}, {7,5,-1,0}, {7,5,-1,0}, {7,5,-1,0}, {7,5,-1,0},
+     {7,5,-1,-1}, {7,5,-1,-1}, {7,4,1,1}, {7,4,1,1}, {7,4,1,1},
+     {7,4,1,0}, {7,4,1,0}, {7,4,1,0}, {7,4,1,0}, {7,4,1,0}},
+    // key 85: A7
+    {{7,5,0,2}, {7,5,0,2}, {7,5,0,2}, {7,5,0,2}, {7,5,0,2},
+     {7,5,0,0}, {7,5,0,0}, {7,5,0,0}, {7,5,0,0}, {7,5,0,0},
+     {7,5,0,0}, {7,5,0,0}, {7,5,0,2}, {7,5,0,2}, {7,5,0,2}},
+    // key 86: A#/Bb7
+    {{7,6,-1,0}, {7,6,-1,0}, {7,6,-1,0}, {7,6,-1,0}, {7,6,-1,0},
+     {7,6,-1,0}, {7,6,-1,0}, {7,5,1,1}, {7,5,1,1}, {7,5,1,1},
+     {7,5,1,1}, {7,5,1,1}, {7,5,1,0}, {7,5,1,0}, {7,5,1,0}},
+    // key 87: B7
+    {{7,6,0,0}, {7,6,0,0}, {7,6,0,2}, {7,6,0,2}, {7,6,0,2},
+     {7,6,0,2}, {7,6,0,2}, {7,6,0,0}, {7,6,0,0}, {7,6,0,0},
+     {7,6,0,0}, {7,6,0,0}, {7,6,0,0}, {7,6,0,0}, {7,6,0,2}},
+    // key 88: C8
+    {{8,0,0,2}, {8,0,0,2}, {8,0,0,0}, {8,0,0,0}, {8,0,0,0},
+     {8,0,0,0}, {8,0,0,0}, {8,0,0,0}, {8,0,0,0}, {8,0,0,2},
+     {8,0,0,2}, {8,0,0,2}, {8,0,0,2}, {8,0,0,2}, {8,0,0,0}}};
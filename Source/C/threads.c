@@ -0,0 +1,50 @@
+/********************************************************************************
+ *
+ * Threads
+ *
+ *  © Phil Ngo, Tyler Clites 2012
+ *
+ * The small amount of pthreads and unistd that the analysis needs, in a file
+ * of its own so that musicxml.h never sees unistd.h.
+ *
+********************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "threads.h"
+
+/**
+*   Returns the number of processors online, at least 1
+**/
+int numProcessors(void)
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return (count > 0) ? count : 1;
+}
+
+/**
+*   Calls work(args[i]) on each of num_threads threads and waits for all of them.
+*   A thread that can't be started has its work done by the caller instead.
+**/
+int runThreads(int num_threads, void* (*work)(void*), void* args[])
+{
+    pthread_t threads[num_threads];
+    int started[num_threads];
+
+    // the caller takes the first share itself
+    for (int i = 1; i < num_threads; i++)
+        started[i] = (pthread_create(&threads[i], NULL, work, args[i]) == 0);
+    work(args[0]);
+
+    for (int i = 1; i < num_threads; i++)
+    {
+        if (started[i])
+            pthread_join(threads[i], NULL);
+        else
+            work(args[i]);
+    }
+    return 0;
+}
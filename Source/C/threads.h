@@ -0,0 +1,18 @@
+#ifndef THREADS_H
+#define THREADS_H
+
+// kept apart from musicxml.h: unistd.h declares a read() of its own, which
+// clashes with ours, so only threads.c includes it
+
+/**
+*   Returns the number of processors online, at least 1
+**/
+int numProcessors(void);
+
+/**
+*   Calls work(args[i]) on each of num_threads threads and waits for all of them.
+*   A thread that can't be started has its work done by the caller instead.
+**/
+int runThreads(int num_threads, void* (*work)(void*), void* args[]);
+
+#endif
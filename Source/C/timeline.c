@@ -0,0 +1,1189 @@
+/********************************************************************************
+ *
+ * Timelines
+ *
+ *  © Phil Ngo, Tyler Clites 2012
+ *
+ * A Timeline keeps a voice (or a rhythm) as parallel arrays with one entry per
+ * note, and the onset of every note next to its duration. Its length is known
+ * and any note can be reached by its index, so nothing has to walk a list to
+ * count it or to find where it is. A ChordTimeline does the same for a harmony.
+ *
+ * The harmonizing functions work on timelines. Their Part, Rhythm and Harmony
+ * versions in musicxml.c convert to and from the lists with the functions here.
+ *
+********************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "musicxml.h"
+
+/**
+*   Returns an empty timeline with room for capacity notes, from the arena
+*   if there is one. NULL if memory runs out
+**/
+Timeline* timelineAlloc(int capacity, Arena* arena)
+{
+    Timeline* timeline = arenaMalloc(arena, sizeof(Timeline));
+    if (timeline == NULL)
+        return NULL;
+
+    if (capacity < 16)
+        capacity = 16;
+    timeline->length = 0;
+    timeline->capacity = capacity;
+    timeline->arena = arena;
+    timeline->note_num = arenaMalloc(arena, sizeof(int) * capacity);
+    timeline->duration = arenaMalloc(arena, sizeof(int) * capacity);
+    timeline->onset = arenaMalloc(arena, sizeof(int) * capacity);
+    timeline->staff = arenaMalloc(arena, sizeof(int) * capacity);
+    timeline->rest = arenaMalloc(arena, sizeof(int) * capacity);
+    if (timeline->note_num == NULL || timeline->duration == NULL || timeline->onset == NULL ||
+            timeline->staff == NULL || timeline->rest == NULL)
+    {
+        timelineFree(timeline);
+        return NULL;
+    }
+    return timeline;
+}
+
+/**
+*   Frees a timeline and its arrays, unless they belong to an arena
+**/
+int timelineFree(Timeline* timeline)
+{
+    if (timeline == NULL)
+        return 0;
+    Arena* arena = timeline->arena;
+    arenaRelease(arena, timeline->note_num);
+    arenaRelease(arena, timeline->duration);
+    arenaRelease(arena, timeline->onset);
+    arenaRelease(arena, timeline->staff);
+    arenaRelease(arena, timeline->rest);
+    arenaRelease(arena, timeline);
+    return 0;
+}
+
+/**
+*   Adds a note to the end of a timeline. Returns 0, or 1 if memory runs out
+**/
+int timelineAppend(Timeline* timeline, int note_num, int duration, int staff, int rest)
+{
+    return timelineInsert(timeline, timeline->length, note_num, duration, staff, rest);
+}
+
+/**
+*   Adds a note before the one at index, moving the later notes back by its duration.
+*   Returns 0, or 1 if the index is out of range or memory runs out
+**/
+int timelineInsert(Timeline* timeline, int index, int note_num, int duration, int staff, int rest)
+{
+    if (index < 0 || index > timeline->length)
+    {
+        printf("Error: timelineInsert: no note %d\n", index);
+        return 1;
+    }
+
+    // double the room when it runs out
+    if (timeline->length == timeline->capacity)
+    {
+        int capacity = timeline->capacity * 2;
+        int* note_nums = arenaRealloc(timeline->arena, timeline->note_num, sizeof(int) * timeline->capacity, sizeof(int) * capacity);
+        if (note_nums != NULL)
+            timeline->note_num = note_nums;
+        int* durations = arenaRealloc(timeline->arena, timeline->duration, sizeof(int) * timeline->capacity, sizeof(int) * capacity);
+        if (durations != NULL)
+            timeline->duration = durations;
+        int* onsets = arenaRealloc(timeline->arena, timeline->onset, sizeof(int) * timeline->capacity, sizeof(int) * capacity);
+        if (onsets != NULL)
+            timeline->onset = onsets;
+        int* staves = arenaRealloc(timeline->arena, timeline->staff, sizeof(int) * timeline->capacity, sizeof(int) * capacity);
+        if (staves != NULL)
+            timeline->staff = staves;
+        int* rests = arenaRealloc(timeline->arena, timeline->rest, sizeof(int) * timeline->capacity, sizeof(int) * capacity);
+        if (rests != NULL)
+            timeline->rest = rests;
+        if (note_nums == NULL || durations == NULL || onsets == NULL || staves == NULL || rests == NULL)
+            return 1;
+        timeline->capacity = capacity;
+    }
+
+    // make room at index
+    int later = timeline->length - index;
+    memmove(&timeline->note_num[index + 1], &timeline->note_num[index], sizeof(int) * later);
+    memmove(&timeline->duration[index + 1], &timeline->duration[index], sizeof(int) * later);
+    memmove(&timeline->onset[index + 1], &timeline->onset[index], sizeof(int) * later);
+    memmove(&timeline->staff[index + 1], &timeline->staff[index], sizeof(int) * later);
+    memmove(&timeline->rest[index + 1], &timeline->rest[index], sizeof(int) * later);
+    for (int i = index + 1; i <= timeline->length; i++)
+        timeline->onset[i] += duration;
+
+    timeline->note_num[index] = note_num;
+    timeline->duration[index] = duration;
+    timeline->onset[index] = (index == 0) ? 0 : timeline->onset[index - 1] + timeline->duration[index - 1];
+    timeline->staff[index] = staff;
+    timeline->rest[index] = rest;
+    timeline->length++;
+    return 0;
+}
+
+/**
+*   Returns the length of the whole timeline in divisions
+**/
+int timelineDuration(Timeline* timeline)
+{
+    if (timeline->length == 0)
+        return 0;
+    return timeline->onset[timeline->length - 1] + timeline->duration[timeline->length - 1];
+}
+
+/**
+*   Returns an empty harmony with room for capacity chords, from the arena
+*   if there is one. NULL if memory runs out
+**/
+ChordTimeline* chordTimelineAlloc(int capacity, Arena* arena)
+{
+    ChordTimeline* chords = arenaMalloc(arena, sizeof(ChordTimeline));
+    if (chords == NULL)
+        return NULL;
+
+    if (capacity < 16)
+        capacity = 16;
+    chords->length = 0;
+    chords->capacity = capacity;
+    chords->arena = arena;
+    chords->function = arenaMalloc(arena, sizeof(int) * capacity);
+    chords->type_id = arenaMalloc(arena, sizeof(int) * capacity);
+    chords->inversion = arenaMalloc(arena, sizeof(int) * capacity);
+    chords->duration = arenaMalloc(arena, sizeof(int) * capacity);
+    chords->onset = arenaMalloc(arena, sizeof(int) * capacity);
+    if (chords->function == NULL || chords->type_id == NULL || chords->inversion == NULL ||
+            chords->duration == NULL || chords->onset == NULL)
+    {
+        chordTimelineFree(chords);
+        return NULL;
+    }
+    return chords;
+}
+
+/**
+*   Frees a harmony and its arrays, unless they belong to an arena
+**/
+int chordTimelineFree(ChordTimeline* chords)
+{
+    if (chords == NULL)
+        return 0;
+    Arena* arena = chords->arena;
+    arenaRelease(arena, chords->function);
+    arenaRelease(arena, chords->type_id);
+    arenaRelease(arena, chords->inversion);
+    arenaRelease(arena, chords->duration);
+    arenaRelease(arena, chords->onset);
+    arenaRelease(arena, chords);
+    return 0;
+}
+
+/**
+*   Adds a chord to the end of a harmony. Returns 0, or 1 if memory runs out
+**/
+int chordTimelineAppend(ChordTimeline* chords, int function, int type_id, int inversion, int duration)
+{
+    // double the room when it runs out
+    if (chords->length == chords->capacity)
+    {
+        int capacity = chords->capacity * 2;
+        int* functions = arenaRealloc(chords->arena, chords->function, sizeof(int) * chords->capacity, sizeof(int) * capacity);
+        if (functions != NULL)
+            chords->function = functions;
+        int* type_ids = arenaRealloc(chords->arena, chords->type_id, sizeof(int) * chords->capacity, sizeof(int) * capacity);
+        if (type_ids != NULL)
+            chords->type_id = type_ids;
+        int* inversions = arenaRealloc(chords->arena, chords->inversion, sizeof(int) * chords->capacity, sizeof(int) * capacity);
+        if (inversions != NULL)
+            chords->inversion = inversions;
+        int* durations = arenaRealloc(chords->arena, chords->duration, sizeof(int) * chords->capacity, sizeof(int) * capacity);
+        if (durations != NULL)
+            chords->duration = durations;
+        int* onsets = arenaRealloc(chords->arena, chords->onset, sizeof(int) * chords->capacity, sizeof(int) * capacity);
+        if (onsets != NULL)
+            chords->onset = onsets;
+        if (functions == NULL || type_ids == NULL || inversions == NULL || durations == NULL || onsets == NULL)
+            return 1;
+        chords->capacity = capacity;
+    }
+
+    int last = chords->length;
+    chords->function[last] = function;
+    chords->type_id[last] = type_id;
+    chords->inversion[last] = inversion;
+    chords->duration[last] = duration;
+    chords->onset[last] = (last == 0) ? 0 : chords->onset[last - 1] + chords->duration[last - 1];
+    chords->length++;
+    return 0;
+}
+
+/**
+*   Index of the event sounding at division, from its onsets and durations: the
+*   first one that ends after it. -1 if they have all ended
+**/
+static int indexAt(const int onset[], const int duration[], int length, int division)
+{
+    int low = 0;
+    int high = length;
+    while (low < high)
+    {
+        int mid = low + (high - low) / 2;
+        if (onset[mid] + duration[mid] > division)
+            high = mid;
+        else
+            low = mid + 1;
+    }
+    return (low < length) ? low : -1;
+}
+
+/**
+*   Returns the index of the note sounding at division, -1 if the timeline is over
+**/
+int timelineIndexAt(Timeline* timeline, int division)
+{
+    return indexAt(timeline->onset, timeline->duration, timeline->length, division);
+}
+
+/**
+*   Returns the index of the chord sounding at division, -1 if the harmony is over
+**/
+int chordTimelineIndexAt(ChordTimeline* chords, int division)
+{
+    return indexAt(chords->onset, chords->duration, chords->length, division);
+}
+
+/**
+*   Returns a cursor at the start of a timeline or a harmony
+**/
+TimelineCursor timelineCursor(Timeline* timeline)
+{
+    TimelineCursor cursor = {timeline->onset, timeline->duration, timeline->length, 0};
+    return cursor;
+}
+
+TimelineCursor chordTimelineCursor(ChordTimeline* chords)
+{
+    TimelineCursor cursor = {chords->onset, chords->duration, chords->length, 0};
+    return cursor;
+}
+
+/**
+*   Moves the cursor to the event sounding at division and returns its index, -1 if
+*   they have all ended. Steps forward from where the cursor is, and only searches
+*   when division is before it
+**/
+int cursorIndexAt(TimelineCursor* cursor, int division)
+{
+    int i = cursor->index;
+    if (i > 0 && division < cursor->onset[i - 1] + cursor->duration[i - 1])
+        i = indexAt(cursor->onset, cursor->duration, i, division);
+    while (i < cursor->length && cursor->onset[i] + cursor->duration[i] <= division)
+        i++;
+    cursor->index = i;
+    return (i < cursor->length) ? i : -1;
+}
+
+/**
+*   Returns the measures of the parts, in measures of the given number of beats, from
+*   the arena if there is one. There is always at least one. NULL if memory runs out
+**/
+MeasureIndex* measureIndexAlloc(Timeline* parts[], int num_parts, int beats, Arena* arena)
+{
+    int div_max = beats * DIVISIONS;
+    if (div_max <= 0)
+    {
+        printf("Error: measureIndexAlloc: number of beats not supported\n");
+        return NULL;
+    }
+
+    // enough measures for the longest part
+    int total_divisions = 0;
+    for (int i = 0; i < num_parts; i++)
+        if (timelineDuration(parts[i]) > total_divisions)
+            total_divisions = timelineDuration(parts[i]);
+    int length = (total_divisions + div_max - 1) / div_max;
+    if (length == 0)
+        length = 1;
+
+    MeasureIndex* index = arenaMalloc(arena, sizeof(MeasureIndex));
+    if (index == NULL)
+        return NULL;
+    index->length = length;
+    index->num_parts = num_parts;
+    index->beats = beats;
+    index->arena = arena;
+    index->start = arenaMalloc(arena, sizeof(int) * length);
+    index->first = arenaMalloc(arena, sizeof(int) * length * num_parts);
+    index->tied = arenaMalloc(arena, sizeof(int) * length * num_parts);
+    if (index->start == NULL || (num_parts > 0 && (index->first == NULL || index->tied == NULL)))
+    {
+        measureIndexFree(index);
+        return NULL;
+    }
+
+    // one pass over each part, a measure at a time
+    for (int m = 0; m < length; m++)
+        index->start[m] = m * div_max;
+    for (int i = 0; i < num_parts; i++)
+    {
+        TimelineCursor cursor = timelineCursor(parts[i]);
+        for (int m = 0; m < length; m++)
+        {
+            int n = cursorIndexAt(&cursor, index->start[m]);
+            index->first[m * num_parts + i] = n;
+            index->tied[m * num_parts + i] = (n >= 0 && parts[i]->onset[n] < index->start[m]);
+        }
+    }
+    return index;
+}
+
+/**
+*   Frees a measure index and its arrays, unless they belong to an arena
+**/
+int measureIndexFree(MeasureIndex* index)
+{
+    if (index == NULL)
+        return 0;
+    Arena* arena = index->arena;
+    arenaRelease(arena, index->start);
+    arenaRelease(arena, index->first);
+    arenaRelease(arena, index->tied);
+    arenaRelease(arena, index);
+    return 0;
+}
+
+/**
+*   Returns a timeline of the notes of a part, empty if the part is NULL
+**/
+Timeline* timelineOfPart(Part* part, Arena* arena)
+{
+    Timeline* timeline = timelineAlloc(0, arena);
+    if (timeline == NULL)
+        return NULL;
+
+    for (Part* ptr = part; ptr != NULL; ptr = ptr->next)
+    {
+        if (timelineAppend(timeline, ptr->note_num, ptr->duration, ptr->staff, ptr->rest) != 0)
+        {
+            timelineFree(timeline);
+            return NULL;
+        }
+    }
+    return timeline;
+}
+
+/**
+*   Returns a new Part with the notes of a timeline, NULL if it's empty or memory runs out
+**/
+Part* partOfTimeline(Timeline* timeline)
+{
+    Part* head = NULL;
+    Part* last = NULL;
+    for (int i = 0; i < timeline->length; i++)
+    {
+        Part* ptr = malloc(sizeof(Part));
+        if (ptr == NULL)
+        {
+            rmPart(head);
+            return NULL;
+        }
+        ptr->note_num = timeline->note_num[i];
+        ptr->duration = timeline->duration[i];
+        ptr->staff = timeline->staff[i];
+        ptr->rest = timeline->rest[i];
+        ptr->next = NULL;
+
+        if (head == NULL)
+            head = ptr;
+        else
+            last->next = ptr;
+        last = ptr;
+    }
+    return head;
+}
+
+/**
+*   Returns a timeline with the durations of a rhythm, empty if the rhythm is NULL
+**/
+Timeline* timelineOfRhythm(Rhythm* rhythm, Arena* arena)
+{
+    Timeline* timeline = timelineAlloc(0, arena);
+    if (timeline == NULL)
+        return NULL;
+
+    for (Rhythm* ptr = rhythm; ptr != NULL; ptr = ptr->next)
+    {
+        if (timelineAppend(timeline, 0, ptr->divisions, 0, 0) != 0)
+        {
+            timelineFree(timeline);
+            return NULL;
+        }
+    }
+    return timeline;
+}
+
+/**
+*   Returns a new Rhythm with the durations of a timeline, NULL if it's empty or memory runs out
+**/
+Rhythm* rhythmOfTimeline(Timeline* timeline)
+{
+    Rhythm* head = NULL;
+    Rhythm* last = NULL;
+    for (int i = 0; i < timeline->length; i++)
+    {
+        Rhythm* ptr = malloc(sizeof(Rhythm));
+        if (ptr == NULL)
+        {
+            rmRhythm(head);
+            return NULL;
+        }
+        ptr->divisions = timeline->duration[i];
+        ptr->next = NULL;
+
+        if (head == NULL)
+            head = ptr;
+        else
+            last->next = ptr;
+        last = ptr;
+    }
+    return head;
+}
+
+/**
+*   Returns a timeline of the chords of a harmony, empty if the harmony is NULL
+**/
+ChordTimeline* chordTimelineOfHarmony(Harmony* harmony, Arena* arena)
+{
+    ChordTimeline* chords = chordTimelineAlloc(0, arena);
+    if (chords == NULL)
+        return NULL;
+
+    for (Harmony* ptr = harmony; ptr != NULL; ptr = ptr->next)
+    {
+        if (chordTimelineAppend(chords, ptr->function, ptr->type_id, ptr->inversion, ptr->duration) != 0)
+        {
+            chordTimelineFree(chords);
+            return NULL;
+        }
+    }
+    return chords;
+}
+
+/**
+*   Returns a new Harmony with the chords of a timeline, NULL if it's empty or memory runs out
+**/
+Harmony* harmonyOfChordTimeline(ChordTimeline* chords)
+{
+    Harmony* head = NULL;
+    Harmony* last = NULL;
+    for (int i = 0; i < chords->length; i++)
+    {
+        Harmony* ptr = malloc(sizeof(Harmony));
+        if (ptr == NULL)
+        {
+            rmHarmony(head);
+            return NULL;
+        }
+        ptr->function = chords->function[i];
+        ptr->type_id = chords->type_id[i];
+        ptr->inversion = chords->inversion[i];
+        ptr->duration = chords->duration[i];
+        ptr->next = NULL;
+
+        if (head == NULL)
+            head = ptr;
+        else
+            last->next = ptr;
+        last = ptr;
+    }
+    return head;
+}
+
+/**
+*   Puts a rest before the first note, so the part starts with a pickup of the given number of beats.
+*   Returns 0, or 1 if memory runs out
+**/
+int addPickupTimeline(Timeline* part, int beats, int meter)
+{
+    if (beats <= 0 || part->length == 0)
+        return 0;
+    return timelineInsert(part, 0, part->note_num[0], (meter - beats) * DIVISIONS, part->staff[0], 1);
+}
+
+/**
+*   Returns a rhythm with the same durations as the part
+**/
+Timeline* copyTimelineRhythm(Timeline* part)
+{
+    // error checking
+    if (part == NULL || part->length == 0)
+    {
+        printf("Error: Bad Part\n");
+        return NULL;
+    }
+
+    Timeline* rhythm = timelineAlloc(part->length, part->arena);
+    if (rhythm == NULL)
+        return NULL;
+    for (int i = 0; i < part->length; i++)
+        timelineAppend(rhythm, 0, part->duration[i], 0, 0);
+    return rhythm;
+}
+
+/**
+*   Figures out the n best harmonies for a melody, one chord for each note of the rhythm,
+*   best first, with their scores. Returns how many there are, fewer than n if the melody
+*   has no more, or -1 if something goes wrong
+**/
+int determineHarmoniesTimeline(Timeline* part, Timeline* rhythm, int key, int beats, ChordTimeline* harmonies[], int scores[], int n)
+{
+    // error checking
+    if (part == NULL || rhythm == NULL || part->length == 0 || rhythm->length == 0)
+    {
+        printf("Error determining harmony: no part or no rhythm\n");
+        return -1;
+    }
+    if (n < 1)
+    {
+        printf("Error determining harmony: bad number of harmonies\n");
+        return -1;
+    }
+    int rhythm_node_count = rhythm->length;
+
+    // for each node of the rhythm: how strongly the melody suggests each chord. then for
+    // each chord there, the n best progressions that end on it: their scores, best first,
+    // and the chord and rank before it. entry r for chord j at node i is at (i * 7 + j) * n + r
+    int (*bins)[7] = arenaMalloc(part->arena, sizeof(int[7]) * rhythm_node_count);
+    int* score = arenaMalloc(part->arena, sizeof(int) * rhythm_node_count * 7 * n);
+    int* from_chord = arenaMalloc(part->arena, sizeof(int) * rhythm_node_count * 7 * n);
+    int* from_rank = arenaMalloc(part->arena, sizeof(int) * rhythm_node_count * 7 * n);
+    if (bins == NULL || score == NULL || from_chord == NULL || from_rank == NULL ||
+            harmonyWeights(part, rhythm, key, beats, 0, rhythm_node_count, bins) != 0)
+    {
+        if (bins == NULL || score == NULL || from_chord == NULL || from_rank == NULL)
+            printf("Error allocating memory.\n");
+        arenaRelease(part->arena, bins);
+        arenaRelease(part->arena, score);
+        arenaRelease(part->arena, from_chord);
+        arenaRelease(part->arena, from_rank);
+        return -1;
+    }
+
+    // find the progressions with the highest total weight (k-best viterbi). they start and
+    // end on the tonic, and every chord may follow the one before. -1 marks an empty entry.
+    // ties go to the lower function, so the answer is always the same
+    for (int e = 0; e < 7 * n; e++)
+        score[e] = -1;
+    score[0] = bins[0][0];
+    for (int i = 1; i < rhythm_node_count; i++)
+    {
+        for (int j = 0; j < 7; j++)
+        {
+            int* best = &score[(i * 7 + j) * n];
+            int* best_chord = &from_chord[(i * 7 + j) * n];
+            int* best_rank = &from_rank[(i * 7 + j) * n];
+            for (int r = 0; r < n; r++)
+                best[r] = -1;
+            if (i == rhythm_node_count - 1 && j != 0)
+                continue;
+
+            // merge the lists of the chords that may come before, keeping the n best
+            for (int k = 0; k < 7; k++)
+            {
+                if (!allowedChordProgression(k, j))
+                    continue;
+                int* previous = &score[((i - 1) * 7 + k) * n];
+                for (int r = 0; r < n && previous[r] >= 0; r++)
+                {
+                    int place = n;
+                    while (place > 0 && best[place - 1] < previous[r])
+                        place--;
+                    if (place == n)
+                        break;
+                    for (int s = n - 1; s > place; s--)
+                    {
+                        best[s] = best[s - 1];
+                        best_chord[s] = best_chord[s - 1];
+                        best_rank[s] = best_rank[s - 1];
+                    }
+                    best[place] = previous[r];
+                    best_chord[place] = k;
+                    best_rank[place] = r;
+                }
+            }
+            for (int r = 0; r < n && best[r] >= 0; r++)
+                best[r] += bins[i][j];
+        }
+    }
+
+    // read each progression back from the tonic at the end, one chord for each node of the rhythm
+    int found = 0;
+    int last = (rhythm_node_count - 1) * 7 * n;
+    while (found < n && score[last + found] >= 0)
+    {
+        ChordTimeline* chords = chordTimelineAlloc(rhythm_node_count, part->arena);
+        if (chords == NULL)
+        {
+            printf("Error allocating memory.\n");
+            for (int q = 0; q < found; q++)
+                chordTimelineFree(harmonies[q]);
+            found = -1;
+            break;
+        }
+        int chord = 0;
+        int rank = found;
+        for (int i = rhythm_node_count - 1; i >= 0; i--)
+        {
+            chords->function[i] = chord + 1;
+            chords->type_id[i] = diatonic_types[chord];
+            chords->inversion[i] = 0;
+            chords->duration[i] = rhythm->duration[i];
+            chords->onset[i] = rhythm->onset[i];
+            if (i > 0)
+            {
+                int e = (i * 7 + chord) * n + rank;
+                chord = from_chord[e];
+                rank = from_rank[e];
+            }
+        }
+        chords->length = rhythm_node_count;
+        harmonies[found] = chords;
+        scores[found] = score[last + found];
+        found++;
+    }
+
+    arenaRelease(part->arena, bins);
+    arenaRelease(part->arena, score);
+    arenaRelease(part->arena, from_chord);
+    arenaRelease(part->arena, from_rank);
+    return found;
+}
+
+/**
+*   Figures out the best harmony for a melody, one chord for each note of the rhythm
+**/
+ChordTimeline* determineHarmonyTimeline(Timeline* part, Timeline* rhythm, int key, int beats)
+{
+    ChordTimeline* chords;
+    int score;
+    if (determineHarmoniesTimeline(part, rhythm, key, beats, &chords, &score, 1) != 1)
+        return NULL;
+    return chords;
+}
+
+/**
+*   Determines the meter of a part. Returns {beats, offset}, NULL if none fits
+**/
+int* determineMeterTimeline(Timeline* part)
+{
+    int meter[2] = {288, 384};
+    int max_score = 0;
+    int final_offset = 0;
+    int final_meter = 0;
+
+    for (int offset = 0; offset < 384; offset += DIVISIONS)
+    {
+        int meter_score[2] = {0,0};
+        for (int n = 0; n < part->length; n++)
+        {
+            for (int i = 0; i < 2; i++)
+            {
+                if (part->onset[n] % meter[i] == offset)
+                    meter_score[i] += 2;
+                else if (i == 1 && part->onset[n] % meter[i] == (meter[i] / 2) + offset)
+                    meter_score[i]++;
+            }
+        }
+
+        for (int i = 0; i < 2; i++)
+        {
+            if (max_score < meter_score[i])
+            {
+                max_score = meter_score[i];
+                final_offset = offset;
+                final_meter = (i == 0) ? 3 : 4;
+            }
+        }
+    }
+
+    if (final_meter == 0)
+        return NULL;
+
+    int* final_values = arenaMalloc(part->arena, sizeof(int) * 2);
+    if (final_values == NULL)
+    {
+        printf("Error allocating memory.\n");
+        return NULL;
+    }
+    final_values[0] = final_meter;
+    final_values[1] = final_offset;
+
+    return final_values;
+}
+
+/**
+*   Returns the notes a counterpoint part may play for a chord of the harmony at a
+*   division: the notes of the chord within its bounds that none of other_parts plays then
+**/
+Range counterpointRange(ChordTimeline* harmony, int chord, Timeline* other_parts[], TimelineCursor part_cursor[], int num_parts, int division, int key)
+{
+    // these are the acceptable ranges to make bass and tenor parts - key 25 to key 40
+    Range bounds = rangeOfKeys(25, 40);
+
+    Range taken = {.keys = {0, 0}};
+    for (int i = 0; i < num_parts; i++)
+    {
+        int other = cursorIndexAt(&part_cursor[i], division);
+        if (other >= 0 && !other_parts[i]->rest[other])
+            taken = rangeWith(taken, other_parts[i]->note_num[other]);
+    }
+    Range allowed_range = getRange(harmony->function[chord], harmony->type_id[chord], key);
+    return rangeWithout(rangeIntersect(allowed_range, bounds), taken);
+}
+
+/**
+*   Returns the note a counterpoint part moves to from previous_note, for a chord of the
+*   harmony at a division: the nearest note of counterpointRange() less than an octave
+*   away, either way at random if two are as near. Stays put if there is none
+**/
+int counterpointNote(ChordTimeline* harmony, int chord, Timeline* other_parts[], TimelineCursor part_cursor[], int num_parts, int division, int key, int previous_note, Rng* rng)
+{
+    Range allowed_range = counterpointRange(harmony, chord, other_parts, part_cursor, num_parts, division, key);
+    int up = rangeAbove(allowed_range, previous_note);
+    int down = rangeBelow(allowed_range, previous_note);
+    int up_distance = (up != 0) ? up - previous_note : 12;
+    int down_distance = (down != 0) ? previous_note - down : 12;
+    if (up_distance < 12 && up_distance == down_distance)
+        return (rngBelow(rng, 2) == 0) ? up : down;
+    else if (up_distance < 12 && up_distance < down_distance)
+        return up;
+    else if (down_distance < 12)
+        return down;
+    return previous_note;
+}
+
+/**
+*   Writes a counterpoint part for a harmony, one note for each note of the rhythm,
+*   avoiding the notes that other_parts are playing at the time
+**/
+Timeline* getCounterpointTimeline(ChordTimeline* harmony, Timeline* rhythm, Timeline* other_parts[], int num_parts, int key, int staff, Rng* rng)
+{
+    if (harmony == NULL || rhythm == NULL)
+    {
+        printf("Error: getCounterpointPart: no harmony or no rhythm\n");
+        return NULL;
+    }
+    Timeline* new_part = timelineAlloc(rhythm->length, harmony->arena);
+    if (new_part == NULL)
+        return NULL;
+
+    // where we are in the harmony and in each of the other parts
+    TimelineCursor harmony_cursor = chordTimelineCursor(harmony);
+    TimelineCursor part_cursor[num_parts];
+    for (int i = 0; i < num_parts; i++)
+        part_cursor[i] = timelineCursor(other_parts[i]);
+
+    // start in the octave below middle C (C3 to C4), and track the previous note
+    int previous_note = 28 + norm_from_C[key + 7];
+
+    // loop over nodes in the rhythm, until the harmony runs out
+    for (int n = 0; n < rhythm->length; n++)
+    {
+        int chord = cursorIndexAt(&harmony_cursor, rhythm->onset[n]);
+        if (chord < 0)
+            break;
+
+        int note_num = counterpointNote(harmony, chord, other_parts, part_cursor, num_parts, rhythm->onset[n], key, previous_note, rng);
+        if (timelineAppend(new_part, note_num, rhythm->duration[n], staff, 0) != 0)
+        {
+            timelineFree(new_part);
+            return NULL;
+        }
+
+        // remember the previous note
+        previous_note = note_num;
+    }
+
+    return new_part;
+}
+
+/**
+*   Reads the number at text, with the spaces around it and a sign, into number and moves
+*   text past it. Returns 1, or 0 if there are no digits there or too many for an int
+**/
+static int readNumber(const char** text, const char* end, int* number)
+{
+    const char* c = *text;
+    while (c < end && (*c == ' ' || *c == '\t'))
+        c++;
+    int sign = 1;
+    if (c < end && (*c == '-' || *c == '+'))
+    {
+        if (*c == '-')
+            sign = -1;
+        c++;
+    }
+    // past INT_MAX the value stops growing, so a long run of digits can't overflow it
+    const char* digits = c;
+    long long value = 0;
+    while (c < end && *c >= '0' && *c <= '9')
+    {
+        if (value <= INT_MAX)
+            value = value * 10 + (*c - '0');
+        c++;
+    }
+    if (c == digits || value > INT_MAX)
+        return 0;
+    while (c < end && (*c == ' ' || *c == '\t'))
+        c++;
+    *text = c;
+    *number = sign * value;
+    return 1;
+}
+
+/**
+*   Reads a melody from a file of lines "key number,duration" into a timeline from the
+*   arena. Lines may end in \n or \r\n and the last one may not end at all. Lines that
+*   don't start with a number, a comma and a number, or whose key isn't 0 to 88 or whose
+*   duration isn't positive, are skipped. NULL if the file can't be read or memory runs out
+**/
+Timeline* getPartTimeline(const char* filename, Arena* arena)
+{
+    // attempt to open the file
+    FILE* fp = fopen(filename, "r");
+    if (fp == NULL)
+    {
+        printf("ERROR: bad input file for melody\n");
+        return NULL;
+    }
+    struct stat info;
+    if (fstat(fileno(fp), &info) != 0)
+    {
+        printf("ERROR: bad input file for melody\n");
+        fclose(fp);
+        return NULL;
+    }
+    size_t size = info.st_size;
+    if (size == 0)
+    {
+        fclose(fp);
+        return timelineAlloc(0, arena);
+    }
+
+    // map the whole file, and keep it only as long as it takes to read
+    const char* text = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+    fclose(fp);
+    if (text == MAP_FAILED)
+    {
+        printf("ERROR: bad input file for melody\n");
+        return NULL;
+    }
+    const char* end = text + size;
+
+    // one note at most per line. a plain loop over the bytes vectorizes, where memchr
+    // stops at every line
+    size_t lines = 1;
+    for (size_t i = 0; i < size; i++)
+        lines += (text[i] == '\n');
+    Timeline* part = (lines <= INT_MAX) ? timelineAlloc(lines, arena) : NULL;
+    if (part == NULL)
+    {
+        munmap((void*) text, size);
+        return NULL;
+    }
+
+    // one line at a time, straight into the arrays
+    int onset = 0;
+    const char* c = text;
+    while (c < end)
+    {
+        int note_num;
+        int duration;
+        int found = readNumber(&c, end, &note_num) && c < end && *c == ',';
+        if (found)
+        {
+            c++;
+            found = readNumber(&c, end, &duration);
+        }
+
+        // onsets have to go up for timelineIndexAt(), and stay within an int
+        if (found && note_num >= 0 && note_num <= 88 && duration > 0 && duration <= INT_MAX - onset)
+        {
+            int n = part->length++;
+            part->note_num[n] = note_num;
+            part->duration[n] = duration;
+            part->onset[n] = onset;
+            part->staff[n] = 1;
+            part->rest[n] = 0;
+            onset += part->duration[n];
+        }
+
+        // the rest of the line, \r and all
+        while (c < end && *c++ != '\n')
+            ;
+    }
+
+    munmap((void*) text, size);
+    return part;
+}
+
+/**
+*   Returns a rhythm at least divisions long, in the harmonic rhythm style given, from the arena
+**/
+Timeline* getRhythmTimeline(int divisions, int beats, int style, Arena* arena)
+{
+    // error checking
+    if (beats < 2 || beats > 4)
+    {
+        printf("Error: getRhythm: number of beats not supported\n");
+        return NULL;
+    }
+
+    Timeline* rhythm = timelineAlloc(0, arena);
+    if (rhythm == NULL)
+        return NULL;
+
+    int div_counter = 0;
+    while (div_counter < divisions)
+    {
+        // depending on the harmonization style, output different rhythms
+        int duration;
+        switch (style)
+        {
+            case 0:
+                duration = DIVISIONS * beats;
+                break;
+            case 1:
+                duration = DIVISIONS;
+                break;
+            case 2:
+                duration = DIVISIONS * 2;
+                break;
+            default:
+                duration = DIVISIONS * beats;
+        }
+        if (timelineAppend(rhythm, 0, duration, 0, 0) != 0)
+        {
+            timelineFree(rhythm);
+            return NULL;
+        }
+        div_counter += duration;
+    }
+
+    return rhythm;
+}
+
+/**
+*   Fills bins with how strongly the melody suggests each chord (by function - 1) at
+*   nodes first to first + count - 1 of the rhythm, bins[0] for node first: every note
+*   adds its weight, more on a downbeat, to each chord that could harmonize it, at the
+*   node it starts in. Returns 0, or 1 if the arguments don't fit
+**/
+int harmonyWeights(Timeline* part, Timeline* rhythm, int key, int beats, int first, int count, int bins[][7])
+{
+    // error checking
+    if (key < -7 || key > 7)
+    {
+        printf("Error determining harmony: bad key\n");
+        return 1;
+    }
+    if (timelineDuration(rhythm) < timelineDuration(part))
+    {
+        printf("Error: Rhythm is not as long as the part\n");
+        return 1;
+    }
+    if (beats != 3 && beats != 4)
+    {
+        printf("Error (determineHarmony): # beats not supported\n");
+        return 1;
+    }
+    if (first < 0 || count < 0 || first + count > rhythm->length)
+    {
+        printf("Error determining harmony: nodes out of range\n");
+        return 1;
+    }
+    for (int i = 0; i < count; i++)
+        for (int j = 0; j < 7; j++)
+            bins[i][j] = 0;
+    if (count == 0)
+        return 0;
+
+    // loop over the notes that start in those nodes, from the first that sounds in them
+    int node = first;
+    int end = rhythm->onset[first + count - 1] + rhythm->duration[first + count - 1];
+    int start = timelineIndexAt(part, rhythm->onset[first]);
+    for (int i = (start >= 0) ? start : part->length; i < part->length && part->onset[i] < end; i++)
+    {
+        if (part->onset[i] < rhythm->onset[first])
+            continue;
+        while (part->onset[i] >= rhythm->onset[node] + rhythm->duration[node])
+            node++;
+
+        // figure out if were on a downbeat and apply a weight to notes on a downbeat
+        int downbeat_factor;
+        if (beats == 4)
+        {
+            if (part->onset[i] % (DIVISIONS * beats) == 0)
+                downbeat_factor = 4;
+            else if (part->onset[i] % (DIVISIONS * beats / 2) == 0)
+                downbeat_factor = 3;
+            else
+                downbeat_factor = 2;
+        }
+        else
+        {
+            if (part->onset[i] % (DIVISIONS * beats) == 0)
+                downbeat_factor = 2;
+            else
+                downbeat_factor = 1;
+        }
+
+        // rests have no note to harmonize
+        int candidates = part->rest[i] ? 0 : chord_candidates[key + 7][part->note_num[i] % 12];
+        for (int j = 0; j < 7; j++)
+            if (candidates & (1 << j))
+                bins[node - first][j] += downbeat_factor;
+    }
+
+    return 0;
+}
+
+/**
+*   Transposes a part from old key to new key, shifting either up or down.
+*   Returns the shift in semitones
+**/
+int transposeTimeline(Timeline* part, int old_key, int new_key, int shift_direction)
+{
+    if (new_key == old_key)
+        return 0;
+
+    int shift = norm_from_C[new_key + 7] - norm_from_C[old_key + 7];
+
+    // determine amount to shift by
+    if (shift_direction == 1 && shift < 0)
+        shift += 12;
+    else if (shift_direction == -1 && shift > 0)
+        shift -= 12;
+    else if (shift_direction != 1 && shift_direction != -1)
+        printf("Error: shift direction must be either 1 or -1\n");
+
+    // keep every note on the keyboard
+    for (int i = 0; i < part->length; i++)
+    {
+        if (shift_direction == 1)
+            part->note_num[i] += (part->note_num[i] + shift > 88) ? shift - 12 : shift;
+        else
+            part->note_num[i] += (part->note_num[i] + shift < 1) ? 12 + shift : shift;
+    }
+
+    return shift;
+}
+
+/**
+*   Writes measures first to last (counting from 1) of the parts to a file, one staff
+*   each. Notes that cross a barline are split into tied notes. The first measure
+*   written gives the key, time and clefs, whatever its number
+**/
+int writeMeasures(const char* filename, Timeline* parts[], MeasureIndex* index, int first, int last, int key, char* composer, char* title)
+{
+    if (index == NULL || first < 1 || last > index->length || first > last)
+    {
+        printf("Error: writeMeasures: no such measures\n");
+        return -1;
+    }
+
+    // write header, doc, root, and dtd
+    xmlDocPtr doc = xmlNewDoc(BAD_CAST "1.0");
+    xmlNodePtr xml_part = writeHeader(doc, composer, title);
+    xmlNodePtr measure;
+
+    int num_parts = index->num_parts;
+    int div_max = index->beats * DIVISIONS;
+    for (int m = first - 1; m < last; m++)
+    {
+        // define measure attributes
+        measure = xmlNewChild(xml_part, NULL, BAD_CAST "measure", NULL);
+        MeasureAttribute attributes = {.key = key, .num = m + 1, .beats = index->beats, .beat_type = 4,
+                                       .opening = (m == first - 1)};
+        writeMeasureAttributes(measure, attributes);
+        int measure_start = index->start[m];
+        int measure_end = measure_start + div_max;
+
+        // count the number of divisions written per part
+        int div_counter = 0;
+
+        // loop over parts for this measure
+        for (int i = 0; i < num_parts; i++)
+        {
+            // back by the amount written in the last part
+            if (div_counter != 0)
+            {
+                char backup_dur_s[MAX_STRING];
+                sprintf(backup_dur_s, "%d", div_counter);
+                xmlNodePtr backup = xmlNewChild(measure, NULL, BAD_CAST "backup", NULL);
+                xmlNewChild(backup, NULL, BAD_CAST "duration", BAD_CAST backup_dur_s);
+                div_counter = 0;
+            }
+
+            // write the notes sounding in this measure, cut at the bar lines and tied across them
+            int first_note = index->first[m * num_parts + i];
+            int tied_in = index->tied[m * num_parts + i];
+            for (int n = first_note; n >= 0 && n < parts[i]->length && parts[i]->onset[n] < measure_end; n++)
+            {
+                int onset = parts[i]->onset[n];
+                int end = onset + parts[i]->duration[n];
+                int start = (onset > measure_start) ? onset : measure_start;
+                int stop = (end < measure_end) ? end : measure_end;
+
+                // make sure the note is valid
+                Note note = getNote(parts[i]->note_num[n], attributes.key);
+                if (note.step == 0 && note.octave == 0 && note.alter == 0)
+                {
+                    printf("Error: Invalid note number\n");
+                    xmlFreeDoc(doc);
+                    return -1;
+                }
+
+                // a note tied in from the measure before and on into the next gets both
+                int tie_stop = (n == first_note && tied_in);
+                int tie_start = (end > measure_end);
+                int tie_type = (tie_stop && tie_start) ? 2 : tie_start ? 1 : tie_stop ? -1 : 0;
+                writeNote(measure, note, stop - start, tie_type, -1, 0,
+                        parts[i]->staff[n], -1, -1, parts[i]->rest[n]);
+                div_counter += stop - start;
+            }
+        }
+    }
+
+    // save the file with format information
+    xmlSaveFormatFileEnc(filename, doc, "UTF-8", 1);
+    xmlFreeDoc(doc);
+    xmlCleanupParser();
+
+    // success
+    return 0;
+}
+
+/**
+*   Writes parts to a file, one staff each, splitting the notes that cross a barline into tied notes
+**/
+int writeTimelines(const char* filename, Timeline* parts[], int num_parts, int beats, int key, char* composer, char* title)
+{
+    MeasureIndex* index = measureIndexAlloc(parts, num_parts, beats, NULL);
+    if (index == NULL)
+    {
+        printf("Error allocating memory.\n");
+        return -1;
+    }
+    int status = writeMeasures(filename, parts, index, 1, index->length, key, composer, title);
+    measureIndexFree(index);
+    return status;
+}
@@ -0,0 +1,82 @@
+/********************************************************************************
+ *
+ * Diagnostics viewer
+ *
+ *  © Phil Ngo, Tyler Clites 2012
+ *
+ * Prints a diagnostics file written by read() (import --diagnostics=[file]) the
+ * way visual.txt used to look: for each note, the strongest fft peaks as
+ * frequency:amplitude, then a histogram of those peaks over the 88 keys.
+ *
+ *  usage: visual [diagnostics file] > visual.txt
+ *
+********************************************************************************/
+
+#include "musicxml.h"
+
+int printDiagnostics(FILE* out, NoteDiagnostics* note);
+
+int main(int argc, char* argv[])
+{
+    if (argc != 2)
+    {
+        printf("USAGE: visual [diagnostics file]\n");
+        return 1;
+    }
+
+    FILE* fp = fopen(argv[1], "rb");
+    if (fp == NULL)
+    {
+        printf("Error opening %s\n", argv[1]);
+        return 1;
+    }
+
+    char magic[4];
+    if (fread(magic, 1, 4, fp) != 4 || memcmp(magic, DIAGNOSTICS_MAGIC, 4) != 0)
+    {
+        printf("Error: %s is not a diagnostics file\n", argv[1]);
+        fclose(fp);
+        return 1;
+    }
+
+    NoteDiagnostics note;
+    while (fread(&note, sizeof(NoteDiagnostics), 1, fp) == 1)
+        printDiagnostics(stdout, &note);
+
+    fclose(fp);
+    return 0;
+}
+
+/**
+*   Prints the peaks and the histogram of one note
+**/
+int printDiagnostics(FILE* out, NoteDiagnostics* note)
+{
+    for (int j = 0; j < NUMMAX; j++)
+        fprintf(out, "%.0f:%.0f\n", note->frequency[j], note->amplitude[j]);
+
+    fprintf(out, "\n-----------------------\n");
+    char* names[12] = {"    A",
+            "A#/Bb",
+            "    B",
+            "    C",
+            "C#/Db",
+            "    D",
+            "D#/Eb",
+            "    E",
+            "    F",
+            "F#/Gb",
+            "    G",
+            "G#/Ab"};
+
+    // one bar per key, a row of #s as long as the count
+    char bar[256];
+    for (int i = 0; i < 88; i++)
+    {
+        memset(bar, '#', note->histogram[i]);
+        bar[note->histogram[i]] = '\0';
+        fprintf(out, "%s(%d):%s\n", names[i % 12], (i + 1), bar);
+    }
+    fprintf(out, "\n***********************\n\n");
+    return 0;
+}